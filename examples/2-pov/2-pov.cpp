@@ -0,0 +1,74 @@
+/*------------------------------------------------------------------------
+  Particle library to control Adafruit DotStar addressable RGB LEDs.
+
+  Persistence-of-vision example: sweeps a small image column by column
+  at a fixed column rate.  Wave the strip (or spin it) to see the image.
+  With a Hall sensor on SYNCPIN pulsing once per revolution, the image
+  is re-phased every turn and the column rate follows the spin speed.
+  ------------------------------------------------------------------------*/
+
+/* ======================= includes ================================= */
+
+#include "Particle.h"
+
+#include "dotstar.h"
+#include "dotstar_pov.h"
+
+#define NUMPIXELS 8     // Number of LEDs in strip (= image height)
+#define COLUMNS   8     // Image width
+#define COLRATE   800   // Columns per second
+// #define SYNCPIN D2   // Optional once-per-revolution sensor
+
+#if (PLATFORM_ID == 32) // P2/Photon2
+Adafruit_DotStar strip(NUMPIXELS, SPI, DOTSTAR_BGR);
+#else
+Adafruit_DotStar strip(NUMPIXELS, DOTSTAR_BGR); // Hardware SPI
+#endif
+
+DotStarPOV pov(strip);
+
+// A red arrow on blue, column-major R,G,B
+#define R 255, 0, 0
+#define B 0, 0, 64
+static const uint8_t image[COLUMNS * NUMPIXELS * 3] = {
+  B, B, B, R, R, B, B, B,
+  B, B, B, R, R, B, B, B,
+  B, B, B, R, R, B, B, B,
+  R, R, R, R, R, R, R, R,
+  B, R, R, R, R, R, R, B,
+  B, B, R, R, R, R, B, B,
+  B, B, B, R, R, B, B, B,
+  B, B, B, B, B, B, B, B,
+};
+#undef R
+#undef B
+
+void setup() {
+  strip.begin();
+  strip.setBrightness(32);              // Before begin(): columns are
+  pov.begin(image, COLUMNS, NUMPIXELS); //  encoded with this brightness
+  pov.setColumnRate(COLRATE);
+#ifdef SYNCPIN
+  pov.attachSync(SYNCPIN);
+#endif
+  pov.start();
+#if PLATFORM_THREADING
+  pov.startThread();                    // Columns no longer wait on loop()
+#endif
+}
+
+void loop() {
+#if PLATFORM_THREADING
+  // The POV thread sends the columns; late ones show up in
+  // pov.missedDeadlines().  At COLRATE it never sleeps, and it runs
+  // above loop()'s priority, so loop() barely runs.  If that matters,
+  // or the cloud connection suffers, use
+  // pov.startThread(OS_THREAD_PRIORITY_DEFAULT) to share the CPU with
+  // loop() at the cost of some column jitter while loop() is busy.
+  delay(1000);
+#else
+  // No threads on this platform: send columns against micros()
+  // deadlines from here, and keep loop() short.
+  pov.service();
+#endif
+}
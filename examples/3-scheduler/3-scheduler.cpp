@@ -0,0 +1,63 @@
+/*------------------------------------------------------------------------
+  Particle library to control Adafruit DotStar addressable RGB LEDs.
+
+  Frame scheduler example: comets run along the strip at a fixed speed
+  in pixels per second, whatever frame rate the strip can manage.  The
+  scheduler aims for TARGETFPS, lowers the rate if rendering plus show()
+  don't fit, and prints what it did to Serial every few seconds.
+  ------------------------------------------------------------------------*/
+
+/* ======================= includes ================================= */
+
+#include "Particle.h"
+
+#include "dotstar.h"
+#include "dotstar_particles.h"
+#include "dotstar_scheduler.h"
+
+#define NUMPIXELS 144   // Number of LEDs in strip
+#define TARGETFPS 120   // Frames per second to aim for
+
+#if (PLATFORM_ID == 32) // P2/Photon2
+Adafruit_DotStar strip(NUMPIXELS, SPI, DOTSTAR_BGR);
+#else
+Adafruit_DotStar strip(NUMPIXELS, DOTSTAR_BGR); // Hardware SPI
+#endif
+
+DotStarParticles<8> comets(strip);
+DotStarScheduler    sched(strip, TARGETFPS);
+
+uint32_t sinceSpawn = 1500, lastReport = 0;
+
+// Called by the scheduler with the real time since the previous frame
+void render(uint32_t ms) {
+  if ((sinceSpawn += ms) >= 1500) {    // New comet every 1.5 seconds
+    comets.spawn(DOTSTAR_FIXED(0), DOTSTAR_FIXED(30), // 30 pixels/s
+                 Adafruit_DotStar::ColorHSV(random(65536)), 0, 8);
+    sinceSpawn = 0;
+  }
+  comets.update(ms);
+  comets.render();
+}
+
+void setup() {
+  Serial.begin(9600);
+  strip.begin();
+  strip.setBrightness(32);
+  sched.begin(render);
+}
+
+void loop() {
+  sched.run();
+
+  if (millis() - lastReport >= 5000) {
+    const DotStarSchedulerStats &s = sched.stats();
+    Serial.printlnf("%u fps (target %u): render %lu us, show %lu us, "
+                    "idle %lu us, %lu overruns, %lu skipped, %lu rate changes",
+                    s.fps, sched.targetFPS(), (unsigned long)s.renderUs,
+                    (unsigned long)s.showUs, (unsigned long)s.idleUs,
+                    (unsigned long)s.overruns, (unsigned long)s.skipped,
+                    (unsigned long)s.rateChanges);
+    lastReport = millis();
+  }
+}
@@ -2,7 +2,8 @@
   Particle library to control Adafruit DotStar addressable RGB LEDs.
 
   Ported by Technobly for Spark Core, Particle Photon, P1, Electron,
-  RedBear Duo, Argon, Boron, Xenon, or Photon2/P2.
+  RedBear Duo, Argon, Boron, Xenon, or Photon2/P2; also builds for Linux
+  single-board computers, with output through /dev/spidev.
 
   ------------------------------------------------------------------------
   -- original header follows ---------------------------------------------
@@ -50,8 +51,19 @@
  */
 
 #include "dotstar.h"
+#include "dotstar_fx.h"
 
-#if PLATFORM_ID == 0 // Core (0)
+#ifdef DOTSTAR_LINUX
+  #include <errno.h>
+  #include <fcntl.h>
+  #include <signal.h>
+  #include <stdio.h>
+  #include <unistd.h>
+  #include <sys/ioctl.h>
+  #include <sys/stat.h>
+  #include <linux/spi/spidev.h>
+  // no pin access, spidev only
+#elif PLATFORM_ID == 0 // Core (0)
   #define pinLO(_pin) (PIN_MAP[_pin].gpio_peripheral->BRR = PIN_MAP[_pin].gpio_pin)
   #define pinHI(_pin) (PIN_MAP[_pin].gpio_peripheral->BSRR = PIN_MAP[_pin].gpio_pin)
 #elif (PLATFORM_ID == 6) || (PLATFORM_ID == 8) || (PLATFORM_ID == 10) || (PLATFORM_ID == 88) // Photon (6), P1 (8), Electron (10) or Redbear Duo (88)
@@ -85,7 +97,7 @@
 void Adafruit_DotStar::spi_out(int n) {
     spi_->transfer(n);
 }
-#else
+#elif !defined(DOTSTAR_LINUX)
 #define spi_out(n) (void)SPI.transfer(n)
 #endif
 
@@ -93,34 +105,68 @@ void Adafruit_DotStar::spi_out(int n) {
 
 #if (PLATFORM_ID == 32)
 Adafruit_DotStar::Adafruit_DotStar(uint16_t n, SPIClass& spi, uint8_t o) :
- numLEDs(n), dataPin(USE_HW_SPI), brightness(0), pixels(NULL),
- rOffset(o & 3), gOffset((o >> 2) & 3), bOffset((o >> 4) & 3)
+ numLEDs(n), dirtyFirst(0), dirtyEnd(0), encVersion(0), wireScale(0),
+ idleUa(0), powerLimit(0), powerOn(false),
+ dataPin(USE_HW_SPI), brightness(0), pixels(NULL),
+ rOffset(o & 3), gOffset((o >> 2) & 3), bOffset((o >> 4) & 3), wire(NULL)
 {
+  chanMa[0]  = chanMa[1]  = chanMa[2]  = 0;
+  chanSum[0] = chanSum[1] = chanSum[2] = 0;
   updateLength(n);
   spi_ = &spi;
 }
 
+#elif defined(DOTSTAR_LINUX)
+// Constructor for Linux spidev.  'device' is normally /dev/spidevB.C, but
+// an existing regular file or FIFO works too, receiving the raw APA102
+// byte stream (handy for testing without a strip).  The path isn't
+// copied.  Frames always go out from the encoded wire buffer (see
+// setWireBuffer()).  If a FIFO's reader goes away, show() just drops
+// the frame; SIGPIPE is held off while writing so it can't kill you.
+Adafruit_DotStar::Adafruit_DotStar(uint16_t n, const char *device,
+  uint32_t hz, uint8_t o) :
+ numLEDs(n), dirtyFirst(0), dirtyEnd(0), encVersion(0), wireScale(0),
+ idleUa(0), powerLimit(0), powerOn(false),
+ dataPin(USE_HW_SPI), brightness(0), pixels(NULL),
+ rOffset(o & 3), gOffset((o >> 2) & 3), bOffset((o >> 4) & 3), wire(NULL),
+ spiDevice(device), spiFd(-1), spiHz(hz), spiChunk(4096), spiIsDev(false)
+{
+  chanMa[0]  = chanMa[1]  = chanMa[2]  = 0;
+  chanSum[0] = chanSum[1] = chanSum[2] = 0;
+  updateLength(n);
+  setWireBuffer(true);
+}
+
 #else
 // Constructor for hardware SPI -- must connect to MOSI, SCK pins
 Adafruit_DotStar::Adafruit_DotStar(uint16_t n, uint8_t o) :
- numLEDs(n), dataPin(USE_HW_SPI), brightness(0), pixels(NULL),
- rOffset(o & 3), gOffset((o >> 2) & 3), bOffset((o >> 4) & 3)
+ numLEDs(n), dirtyFirst(0), dirtyEnd(0), encVersion(0), wireScale(0),
+ idleUa(0), powerLimit(0), powerOn(false),
+ dataPin(USE_HW_SPI), brightness(0), pixels(NULL),
+ rOffset(o & 3), gOffset((o >> 2) & 3), bOffset((o >> 4) & 3), wire(NULL)
 {
+  chanMa[0]  = chanMa[1]  = chanMa[2]  = 0;
+  chanSum[0] = chanSum[1] = chanSum[2] = 0;
   updateLength(n);
 }
 
 // Constructor for 'soft' (bitbang) SPI -- any two pins can be used
 Adafruit_DotStar::Adafruit_DotStar(uint16_t n, uint8_t data, uint8_t clock,
   uint8_t o) :
+ dirtyFirst(0), dirtyEnd(0), encVersion(0), wireScale(0),
+ idleUa(0), powerLimit(0), powerOn(false),
  dataPin(data), clockPin(clock), brightness(0), pixels(NULL),
- rOffset(o & 3), gOffset((o >> 2) & 3), bOffset((o >> 4) & 3)
+ rOffset(o & 3), gOffset((o >> 2) & 3), bOffset((o >> 4) & 3), wire(NULL)
 {
+  chanMa[0]  = chanMa[1]  = chanMa[2]  = 0;
+  chanSum[0] = chanSum[1] = chanSum[2] = 0;
   updateLength(n);
 }
 #endif // #if (PLATFORM_ID == 32)
 
 Adafruit_DotStar::~Adafruit_DotStar(void) { // Destructor
   if (pixels)                free(pixels);
+  if (wire)                  free(wire);
   if (dataPin == USE_HW_SPI) hw_spi_end();
   else                       sw_spi_end();
 }
@@ -138,7 +184,7 @@ void Adafruit_DotStar::begin(void) { // Initialize SPI
 
 // Change to hardware SPI -- must connect to MOSI, SCK pins
 void Adafruit_DotStar::updatePins(void) {
-#if PLATFORM_ID != 32
+#if (PLATFORM_ID != 32) && !defined(DOTSTAR_LINUX)
   sw_spi_end();
   dataPin = USE_HW_SPI;
   hw_spi_init();
@@ -147,11 +193,14 @@ void Adafruit_DotStar::updatePins(void) {
 
 // Change to 'soft' (bitbang) SPI -- any two pins can be used
 void Adafruit_DotStar::updatePins(uint8_t data, uint8_t clock) {
-#if PLATFORM_ID != 32
+#if (PLATFORM_ID != 32) && !defined(DOTSTAR_LINUX)
   hw_spi_end();
   dataPin  = data;
   clockPin = clock;
   sw_spi_init();
+#else
+  (void)data;
+  (void)clock;
 #endif
 }
 
@@ -168,12 +217,69 @@ void Adafruit_DotStar::updateLength(uint16_t n) {
   } else {
     numLEDs = 0;
   }
+  encVersion++;
+  if (wire) {                // Re-size encoded frame to match
+    free(wire);
+    wire = NULL;
+    setWireBuffer(true);
+  }
+}
+
+// Optionally keep a fully-encoded copy of the APA102 frame (start frame,
+// 4 bytes per pixel, end frame) between calls to show().  Only pixels
+// changed since the previous show() are re-encoded, and the frame then
+// goes out in a single bulk (DMA) transfer instead of byte-at-a-time.
+// Costs 4 bytes RAM per pixel on top of the 3 for the pixel data.
+// Returns false if the buffer could not be allocated.  On Linux the
+// buffer is required and can't be turned off.
+boolean Adafruit_DotStar::setWireBuffer(boolean on) {
+#ifdef DOTSTAR_LINUX
+  if (!on) return false;
+#endif
+  if (!on) {
+    if (wire) free(wire);
+    wire = NULL;
+    return true;
+  }
+  if (wire) return true;
+  uint32_t len = encodedLength();
+  if (!(wire = (uint8_t *)malloc(len))) return false;
+  memset(wire, 0, 4);                        // Start-frame marker
+  memset(&wire[4], 0xFF, len - 4);           // Pixel starts, end frame
+  dirtyFirst = 0;                            // Encode everything next show()
+  dirtyEnd   = numLEDs;
+  return true;
+}
+
+// Change the color order.  As with updateLength(), existing pixel data
+// isn't reordered; set colors again afterward.
+void Adafruit_DotStar::updateType(uint8_t o) {
+  rOffset = o & 3;
+  gOffset = (o >> 2) & 3;
+  bOffset = (o >> 4) & 3;
+  encVersion++;
+}
+
+// A counter that changes whenever something that affects the encoded
+// frame other than pixel data does: brightness, color order or length.
+// Anything holding encoded frames (e.g. DotStarFrameCache) compares it
+// to know when those frames have gone stale.
+uint16_t Adafruit_DotStar::encodingVersion(void) const {
+  return encVersion;
+}
+
+// Size of one fully-encoded frame as sent by show() and encode().
+uint32_t Adafruit_DotStar::encodedLength(void) const {
+  // Start frame + 4 bytes per pixel + end frame (see show() below)
+  return 4 + (uint32_t)numLEDs * 4 + (numLEDs + 15) / 16;
 }
 
 // SPI STUFF ---------------------------------------------------------------
 
 void Adafruit_DotStar::hw_spi_init(void) { // Initialize hardware SPI
-#if (PLATFORM_ID != 32)
+#if defined(DOTSTAR_LINUX)
+  linux_spi_init();
+#elif (PLATFORM_ID != 32)
   SPI.begin();
   // 72MHz / 4 = 18MHz (sweet spot)
   // Any slower than 18MHz and you are barely faster than Software SPI.
@@ -189,8 +295,32 @@ void Adafruit_DotStar::hw_spi_init(void) { // Initialize hardware SPI
 #endif
 }
 
+// Write a block of pre-encoded bytes to the strip.  Hardware SPI hands
+// the whole block to the DMA engine; bitbang SPI just loops.  With a
+// 'done' callback, hardware SPI returns immediately and calls it (from
+// interrupt context) once the transfer completes; bitbang SPI finishes
+// the write and then calls it before returning.
+void Adafruit_DotStar::spi_write(const uint8_t *buf, uint32_t len,
+  void (*done)(void)) {
+  if (dataPin == USE_HW_SPI) {
+#if defined(DOTSTAR_LINUX)
+    linux_spi_write(buf, len);
+    if (done) done();
+#elif (PLATFORM_ID == 32)
+    spi_->transfer((void *)buf, NULL, len, done);
+#else
+    SPI.transfer((void *)buf, NULL, len, done);
+#endif
+  } else {
+    while (len--) sw_spi_out(*buf++);
+    if (done) done();
+  }
+}
+
 void Adafruit_DotStar::hw_spi_end(void) { // Stop hardware SPI
-#if (PLATFORM_ID != 32)
+#if defined(DOTSTAR_LINUX)
+  linux_spi_end();
+#elif (PLATFORM_ID != 32)
   SPI.end();
 #else
   spi_->end();
@@ -198,7 +328,7 @@ void Adafruit_DotStar::hw_spi_end(void) { // Stop hardware SPI
 }
 
 void Adafruit_DotStar::sw_spi_init(void) { // Init 'soft' (bitbang) SPI
-#if (PLATFORM_ID != 32)
+#if (PLATFORM_ID != 32) && !defined(DOTSTAR_LINUX)
   pinMode(dataPin , OUTPUT);
   pinMode(clockPin, OUTPUT);
   pinSet(dataPin , LOW);
@@ -207,23 +337,119 @@ void Adafruit_DotStar::sw_spi_init(void) { // Init 'soft' (bitbang) SPI
 }
 
 void Adafruit_DotStar::sw_spi_end() { // Stop 'soft' SPI
-#if (PLATFORM_ID != 32)
+#if (PLATFORM_ID != 32) && !defined(DOTSTAR_LINUX)
   pinMode(dataPin , INPUT);
   pinMode(clockPin, INPUT);
 #endif
 }
 
 void Adafruit_DotStar::sw_spi_out(uint8_t n) { // Bitbang SPI write
-#if (PLATFORM_ID != 32)
+#if (PLATFORM_ID != 32) && !defined(DOTSTAR_LINUX)
   for (uint8_t i=8; i--; n <<= 1) {
     if (n & 0x80) pinSet(dataPin, HIGH);
     else          pinSet(dataPin, LOW);
     pinSet(clockPin, HIGH);
     pinSet(clockPin, LOW);
   }
+#else
+  (void)n;
 #endif
 }
 
+#ifdef DOTSTAR_LINUX
+// LINUX SPIDEV ------------------------------------------------------------
+
+// Open the device given to the constructor.  For a real spidev, set mode
+// 0, 8 bits and the clock, and find the kernel's per-transfer limit
+// (spidev's 'bufsiz' module parameter, 4096 unless changed) so frames go
+// out in as few, as large, transfers as possible.  Anything else (file,
+// FIFO) is just written to.  Opening a FIFO waits for a reader.  The
+// path must already exist (nothing is created, so a mistyped /dev path
+// can't silently turn into a regular file); check isOpen() afterward.
+void Adafruit_DotStar::linux_spi_init(void) {
+  if (spiFd >= 0) return;
+  if ((spiFd = open(spiDevice, O_WRONLY | O_TRUNC)) < 0) return;
+  struct stat st;
+  spiIsDev = !fstat(spiFd, &st) && S_ISCHR(st.st_mode);
+  if (!spiIsDev) return;
+  uint8_t mode = SPI_MODE_0, bits = 8;
+  if ((ioctl(spiFd, SPI_IOC_WR_MODE, &mode) < 0) ||
+      (ioctl(spiFd, SPI_IOC_WR_BITS_PER_WORD, &bits) < 0) ||
+      (ioctl(spiFd, SPI_IOC_WR_MAX_SPEED_HZ, &spiHz) < 0)) {
+    linux_spi_end();                   // Not a usable SPI device
+    return;
+  }
+  FILE *f = fopen("/sys/module/spidev/parameters/bufsiz", "r");
+  if (f) {
+    unsigned long bufsiz;
+    if ((fscanf(f, "%lu", &bufsiz) == 1) && bufsiz) spiChunk = bufsiz;
+    fclose(f);
+  }
+}
+
+// Write 'len' bytes, at most spiChunk per SPI_IOC_MESSAGE.  APA102 has no
+// chip select, so splitting a frame across transfers is harmless.
+// Writing to a FIFO whose reader has closed raises SIGPIPE, and its
+// default action kills the process, so for a file or FIFO it's blocked
+// for the duration: write() fails with EPIPE instead and the rest of
+// the frame is dropped.  A SIGPIPE raised here is consumed before
+// unblocking (one that was already pending is left alone).
+void Adafruit_DotStar::linux_spi_write(const uint8_t *buf, uint32_t len) {
+  if (spiFd < 0) return;
+  sigset_t pipeSet, oldSet, pending;
+  boolean  wasPending = false, broken = false;
+  if (!spiIsDev) {
+    sigemptyset(&pipeSet);
+    sigaddset(&pipeSet, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &pipeSet, &oldSet);
+    wasPending = !sigpending(&pending) &&
+                 (sigismember(&pending, SIGPIPE) == 1);
+  }
+  while (len) {
+    uint32_t n = (len < spiChunk) ? len : spiChunk;
+    if (spiIsDev) {
+      struct spi_ioc_transfer xfer;
+      memset(&xfer, 0, sizeof(xfer));
+      xfer.tx_buf        = (uintptr_t)buf;
+      xfer.len           = n;
+      xfer.speed_hz      = spiHz;
+      xfer.bits_per_word = 8;
+      if (ioctl(spiFd, SPI_IOC_MESSAGE(1), &xfer) < 0) {
+        if (errno == EINTR) continue;
+        break;
+      }
+    } else {
+      ssize_t w = write(spiFd, buf, n);
+      if (w <= 0) {
+        if ((w < 0) && (errno == EINTR)) continue;
+        broken = (w < 0) && (errno == EPIPE);
+        break;                         // Reader gone, disk full, etc.
+      }
+      n = w;
+    }
+    buf += n;
+    len -= n;
+  }
+  if (!spiIsDev) {
+    if (broken && !wasPending) {       // Discard our own SIGPIPE
+      struct timespec zero = { 0, 0 };
+      while ((sigtimedwait(&pipeSet, NULL, &zero) < 0) && (errno == EINTR));
+    }
+    pthread_sigmask(SIG_SETMASK, &oldSet, NULL);
+  }
+}
+
+void Adafruit_DotStar::linux_spi_end(void) {
+  if (spiFd >= 0) close(spiFd);
+  spiFd = -1;
+}
+
+// True once begin() has opened the device.
+boolean Adafruit_DotStar::isOpen(void) const {
+  return spiFd >= 0;
+}
+#endif // DOTSTAR_LINUX
+
 /* ISSUE DATA TO LED STRIP -------------------------------------------------
 
   Although the LED driver has an additional per-pixel 5-bit brightness
@@ -237,13 +463,76 @@ void Adafruit_DotStar::sw_spi_out(uint8_t n) { // Bitbang SPI write
   own use, but any pull requests for this will NOT be merged, nuh uh!
 */
 
+// Scale and encode pixels 'first' through 'end'-1 into their 4-byte
+// APA102 words in an encoded frame 'dst'.  Pixel start bytes and the
+// start/end frames are left untouched.  'scale' 0 means no scaling.
+void Adafruit_DotStar::encode_span(uint8_t *dst, uint16_t first,
+  uint16_t end, uint16_t scale) const {
+  const uint8_t *ptr = &pixels[first * 3];
+  uint8_t       *out = &dst[4 + first * 4];
+  uint16_t       n   = end - first;
+  if (scale) {
+    while (n--) {
+      out[1] = (ptr[0] * scale) >> 8;
+      out[2] = (ptr[1] * scale) >> 8;
+      out[3] = (ptr[2] * scale) >> 8;
+      ptr += 3;
+      out += 4;
+    }
+  } else {
+    while (n--) {
+      out[1] = ptr[0];
+      out[2] = ptr[1];
+      out[3] = ptr[2];
+      ptr += 3;
+      out += 4;
+    }
+  }
+}
+
+// Write a complete encoded frame for the current pixels, as show() would
+// send it, into 'dst' (encodedLength() bytes).
+void Adafruit_DotStar::encode(uint8_t *dst) const {
+  uint32_t len = encodedLength();
+  memset(dst, 0, 4);                   // Start-frame marker
+  memset(&dst[4], 0xFF, len - 4);      // Pixel starts, end frame
+  encode_span(dst, 0, numLEDs, output_scale());
+}
+
+// Send a frame previously produced by encode() (or any other complete
+// APA102 byte stream) as-is, e.g. from a cache of looping frames.  If
+// 'done' is given, see spi_write() above; 'buf' must then stay valid
+// until it's called.
+void Adafruit_DotStar::showEncoded(const uint8_t *buf, uint32_t len,
+  void (*done)(void)) {
+  spi_write(buf, len, done);
+}
+
 void Adafruit_DotStar::show(void) {
 
   if (!pixels) return;
 
+  uint16_t b16 = output_scale();       // Brightness, less power limiting
+
+  if (wire) {                          // Encoded frame kept between calls
+    if (b16 != wireScale) {            // Scale changed, redo it all
+      wireScale  = b16;
+      dirtyFirst = 0;
+      dirtyEnd   = numLEDs;
+    }
+    if (dirtyFirst < dirtyEnd) {       // Re-encode only what changed
+      encode_span(wire, dirtyFirst, dirtyEnd, b16);
+    }
+    dirtyFirst = dirtyEnd = 0;
+    spi_write(wire, encodedLength());
+    return;
+  }
+  dirtyFirst = dirtyEnd = 0;
+
+#ifndef DOTSTAR_LINUX // spidev always sends from 'wire'
   uint8_t *ptr = pixels, i;            // -> LED data
   uint16_t n   = numLEDs;              // Counter
-  uint16_t b16 = (uint16_t)brightness; // Type-convert for fixed-point math
+
 
   //__disable_irq(); // If 100% focus on SPI clocking required
 
@@ -254,7 +543,7 @@ void Adafruit_DotStar::show(void) {
       spi_out(0);                        // Start-frame marker
     }
     // [PIXEL DATA]
-    if (brightness) {                    // Scale pixel brightness on output
+    if (b16) {                           // Scale pixel brightness on output
       do {                               // For each pixel...
         spi_out(0xFF);                   //  Pixel start
         for (i = 0; i < 3; i++) {
@@ -290,7 +579,7 @@ void Adafruit_DotStar::show(void) {
       sw_spi_out(0);                     // Start-frame marker
     }
     // [PIXEL DATA]
-    if (brightness) {                    // Scale pixel brightness on output
+    if (b16) {                           // Scale pixel brightness on output
       do {                               // For each pixel...
         sw_spi_out(0xFF);                //  Pixel start
         for (i = 0; i < 3; i++) {
@@ -321,10 +610,55 @@ void Adafruit_DotStar::show(void) {
   }
 
   //__enable_irq();
+#endif // !DOTSTAR_LINUX
 }
 
 void Adafruit_DotStar::clear() { // Write 0s (off) to full pixel buffer
   memset(pixels, 0, numLEDs * 3);
+  dirtyFirst = 0;
+  dirtyEnd   = numLEDs;
+  chanSum[0] = chanSum[1] = chanSum[2] = 0;
+}
+
+// Flag a span of pixels as changed, for code that writes directly into
+// the getPixels() buffer.  The span is merged into the range re-encoded
+// by the next show().  Count 0 means to end of strip.
+void Adafruit_DotStar::markDirty(uint16_t first, uint16_t count) {
+  if (first >= numLEDs) return;
+  uint16_t end = (count && (count < numLEDs - first)) ?
+                 first + count : numLEDs;
+  if (dirtyFirst >= dirtyEnd) {        // Nothing pending yet
+    dirtyFirst = first;
+    dirtyEnd   = end;
+  } else {
+    if (first < dirtyFirst) dirtyFirst = first;
+    if (end   > dirtyEnd)   dirtyEnd   = end;
+  }
+}
+
+// Copy 'count' pixels of packed R,G,B byte triplets (3 bytes per pixel,
+// always red first regardless of strip color order) starting at pixel
+// 'first'.  Pixels past the end of the strip are ignored.  Handy for
+// bulk transfers, e.g. decoded animation frames.
+void Adafruit_DotStar::setPixels(uint16_t first, uint16_t count,
+  const uint8_t *rgb) {
+  if (first >= numLEDs) return;
+  if (count > numLEDs - first) count = numLEDs - first;
+  if (!count) return;
+  markDirty(first, count);
+  uint8_t *p = &pixels[first * 3];
+  while (count--) {
+    if (powerOn) {
+      chanSum[rOffset] += rgb[0] - p[rOffset];
+      chanSum[gOffset] += rgb[1] - p[gOffset];
+      chanSum[bOffset] += rgb[2] - p[bOffset];
+    }
+    p[rOffset] = rgb[0];
+    p[gOffset] = rgb[1];
+    p[bOffset] = rgb[2];
+    p   += 3;
+    rgb += 3;
+  }
 }
 
 // Set pixel color, separate R,G,B values (0-255 ea.)
@@ -332,6 +666,12 @@ void Adafruit_DotStar::setPixelColor(
  uint16_t n, uint8_t r, uint8_t g, uint8_t b) {
   if (n < numLEDs) {
     uint8_t *p = &pixels[n * 3];
+    markDirty(n, 1);
+    if (powerOn) {                     // Keep power estimate current
+      chanSum[rOffset] += r - p[rOffset];
+      chanSum[gOffset] += g - p[gOffset];
+      chanSum[bOffset] += b - p[bOffset];
+    }
     p[rOffset] = r;
     p[gOffset] = g;
     p[bOffset] = b;
@@ -342,6 +682,12 @@ void Adafruit_DotStar::setPixelColor(
 void Adafruit_DotStar::setPixelColor(uint16_t n, uint32_t c) {
   if (n < numLEDs) {
     uint8_t *p = &pixels[n * 3];
+    markDirty(n, 1);
+    if (powerOn) {                     // Keep power estimate current
+      chanSum[rOffset] += (uint8_t)(c >> 16) - p[rOffset];
+      chanSum[gOffset] += (uint8_t)(c >>  8) - p[gOffset];
+      chanSum[bOffset] += (uint8_t)c         - p[bOffset];
+    }
     p[rOffset] = (uint8_t)(c >> 16);
     p[gOffset] = (uint8_t)(c >>  8);
     p[bOffset] = (uint8_t)c;
@@ -369,6 +715,7 @@ uint16_t Adafruit_DotStar::numPixels(void) { // Ret. strip length
 // being issued to the strip, not during setPixel(), and also means that
 // getPixelColor() returns the exact value originally stored.
 void Adafruit_DotStar::setBrightness(uint8_t b) {
+  if ((uint8_t)(b + 1) != brightness) encVersion++;
   // Stored brightness value is different than what's passed.  This
   // optimizes the actual scaling math later, allowing a fast 8x8-bit
   // multiply and taking the MSB.  'brightness' is a uint8_t, adding 1
@@ -389,6 +736,89 @@ uint8_t *Adafruit_DotStar::getPixels(void) const {
   return pixels;
 }
 
+// POWER ESTIMATION ---------------------------------------------------------
+
+// Describe how much current the strip draws so show() can estimate it
+// and, with setPowerLimit(), scale brightness down to stay in budget.
+// mA_r/g/b are per LED channel at full value (255), idle_uA per pixel
+// with all channels off.  APA102s are roughly 20 mA per channel and
+// 1 mA idle, but measure your own.  Once set, setPixelColor(), fill(),
+// setPixels() and clear() keep running per-channel sums so the estimate
+// is constant-time in show().  Code writing through getPixels() must
+// call updatePower() afterward.
+void Adafruit_DotStar::setPowerModel(uint16_t mA_r, uint16_t mA_g,
+  uint16_t mA_b, uint16_t idle_uA) {
+  chanMa[0] = mA_r;
+  chanMa[1] = mA_g;
+  chanMa[2] = mA_b;
+  idleUa    = idle_uA;
+  powerOn   = (mA_r | mA_g | mA_b | idle_uA) != 0;
+  updatePower();
+  encVersion++;
+}
+
+// Cap the estimated draw at 'mA' (0 = no limit).  When a frame would
+// exceed it, show() dims the whole strip just enough to fit.  Like
+// setBrightness() this is non-destructive: pixel data isn't altered.
+void Adafruit_DotStar::setPowerLimit(uint32_t mA) {
+  powerLimit = mA;
+  encVersion++;
+}
+
+// Recompute the per-channel sums from scratch, one pass over the strip.
+void Adafruit_DotStar::updatePower(void) {
+  chanSum[0] = chanSum[1] = chanSum[2] = 0;
+  if (!powerOn) return;
+  const uint8_t *p = pixels;
+  for (uint16_t n = numLEDs; n--; p += 3) {
+    chanSum[0] += p[0];
+    chanSum[1] += p[1];
+    chanSum[2] += p[2];
+  }
+}
+
+// Current of all color channels at full brightness, in mA.  Sums are
+// kept per pixel byte, so map through the color order offsets.
+uint32_t Adafruit_DotStar::color_current(void) const {
+  uint64_t sum = (uint64_t)chanSum[rOffset] * chanMa[0] +
+                 (uint64_t)chanSum[gOffset] * chanMa[1] +
+                 (uint64_t)chanSum[bOffset] * chanMa[2];
+  return (uint32_t)(sum / 255);
+}
+
+// The brightness scale show() actually applies: the user's setting,
+// reduced if needed to keep the estimated draw within powerLimit.  Same
+// convention as 'brightness': 0 = no scaling, else 1 (off) to 255.
+uint16_t Adafruit_DotStar::output_scale(void) const {
+  uint16_t scale = brightness ? brightness : 256;
+  if (powerOn && powerLimit) {
+    uint32_t idle  = (uint32_t)numLEDs * idleUa / 1000;
+    uint32_t color = color_current();
+    if (color && (idle + ((uint64_t)color * scale >> 8) > powerLimit)) {
+      uint32_t fit = (powerLimit > idle) ?
+                     (uint32_t)(((uint64_t)(powerLimit - idle) << 8) / color) : 0;
+      scale = fit ? fit : 1;           // 1 = off, never "no scaling"
+    }
+  }
+  return (scale >= 256) ? 0 : scale;
+}
+
+// Estimated current in mA for the pixels as they'd be sent by show(),
+// after brightness and any power limiting.  0 if no power model is set.
+uint32_t Adafruit_DotStar::estimatedCurrent(void) const {
+  if (!powerOn) return 0;
+  uint16_t scale = output_scale();
+  uint32_t color = color_current();
+  return (uint32_t)numLEDs * idleUa / 1000 +
+         (scale ? (uint32_t)((uint64_t)color * scale >> 8) : color);
+}
+
+// True if the power limit is currently dimming the strip.
+boolean Adafruit_DotStar::isPowerLimited(void) const {
+  uint16_t scale = output_scale();
+  return scale && (scale != brightness);
+}
+
 /*!
   @brief   Fill all or part of the DotStar strip with a color.
   @param   c      32-bit color value. Most significant byte is 0, second
@@ -576,3 +1006,48 @@ void Adafruit_DotStar::rainbow(uint16_t first_hue, int8_t reps,
     setPixelColor(i, color);
   }
 }
+
+/*!
+  @brief   Fill all or part of the strip with colors from a slice through
+           a 3D gradient noise field, for fire, plasma or cloud effects.
+           Animate by moving through the field, e.g. advancing z or x a
+           little each frame.
+  @param   x           Noise x of the first pixel, 16.16 fixed point.
+  @param   dx          Step in x from one pixel to the next, 16.16 fixed
+                       point; smaller is smoother (0x1000-0x4000 typical).
+  @param   y, z        Remaining noise coordinates, 16.16 fixed point.
+  @param   first       Index of first pixel to fill, as with fill().
+  @param   count       Number of pixels to fill; 0 fills to end of strip.
+  @param   first_hue   Hue (as for ColorHSV()) at the noise midpoint; the
+                       noise value offsets it around the color wheel.
+  @param   saturation  Saturation, 0-255 = gray to pure hue, default 255.
+  @param   brightness  Brightness/value, 0-255 = off to max, default 255.
+  @param   gammify     If true (default), apply gamma correction.
+*/
+void Adafruit_DotStar::noise(uint32_t x, uint32_t dx, uint32_t y,
+                             uint32_t z, uint16_t first, uint16_t count,
+                             uint16_t first_hue, uint8_t saturation,
+                             uint8_t brightness, boolean gammify) {
+  if (first >= numLEDs) return;
+  if (!count || (count > numLEDs - first)) count = numLEDs - first;
+
+  uint16_t n[32];                      // Render in chunks, stack-sized
+  uint8_t  rgb[32 * 3];
+  while (count) {
+    uint16_t len = (count < 32) ? count : 32;
+    DotStarFX::noiseSpan16(n, len, x, dx, y, z);
+    for (uint16_t i = 0; i < len; i++) {
+      uint32_t color = ColorHSV(first_hue + n[i] - 32768, saturation,
+                                brightness);
+      if (gammify)
+        color = gamma32(color);
+      rgb[i * 3]     = color >> 16;
+      rgb[i * 3 + 1] = color >> 8;
+      rgb[i * 3 + 2] = color;
+    }
+    setPixels(first, len, rgb);
+    first += len;
+    count -= len;
+    x     += dx * len;
+  }
+}
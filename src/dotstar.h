@@ -2,7 +2,8 @@
   Particle library to control Adafruit DotStar addressable RGB LEDs.
 
   Ported by Technobly for Spark Core, Particle Photon, P1, Electron,
-  RedBear Duo, Argon, Boron, Xenon, or Photon2/P2.
+  RedBear Duo, Argon, Boron, Xenon, or Photon2/P2; also builds for Linux
+  single-board computers, with output through /dev/spidev.
 
   ------------------------------------------------------------------------
   -- original header follows ---------------------------------------------
@@ -31,7 +32,24 @@
 #ifndef _ADAFRUIT_DOT_STAR_H_
 #define _ADAFRUIT_DOT_STAR_H_
 
+#if defined(__linux__) && !defined(PLATFORM_ID)
+// Linux single-board computer: output goes through /dev/spidev (or any
+// file/FIFO standing in for it), see the device-path constructor below.
+// millis(), micros() and delay() aren't declared here, so this header
+// can be mixed with wiringPi and the like; see dotstar_compat.h.
+#define DOTSTAR_LINUX
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+typedef bool boolean;
+#ifndef PROGMEM
+#define PROGMEM
+#define pgm_read_byte(addr) (*(const uint8_t *)(addr))
+#define pgm_read_word(addr) (*(const uint16_t *)(addr))
+#endif
+#else
 #include "application.h"
+#endif
 
 // Color-order flag for LED pixels (optional extra parameter to constructor):
 // Bits 0,1 = R index (0-2), bits 2,3 = G index, bits 4,5 = B index
@@ -107,6 +125,9 @@ class Adafruit_DotStar {
   // Constructor: number of LEDs, pin number, LED type
 #if (PLATFORM_ID == 32)
     Adafruit_DotStar(uint16_t n, SPIClass& spi, uint8_t o=DOTSTAR_BGR);
+#elif defined(DOTSTAR_LINUX)
+    Adafruit_DotStar(uint16_t n, const char *device, // e.g. /dev/spidev0.0
+                     uint32_t hz=8000000, uint8_t o=DOTSTAR_BGR);
 #else
     Adafruit_DotStar(uint16_t n, uint8_t o=DOTSTAR_BGR);
     Adafruit_DotStar(uint16_t n, uint8_t d, uint8_t c, uint8_t o=DOTSTAR_BGR);
@@ -118,14 +139,39 @@ class Adafruit_DotStar {
     setBrightness(uint8_t),                 // Set global brightness 0-255
     setPixelColor(uint16_t n, uint32_t c),
     setPixelColor(uint16_t n, uint8_t r, uint8_t g, uint8_t b),
+    setPixels(uint16_t first, uint16_t count, const uint8_t *rgb),
+    markDirty(uint16_t first, uint16_t count), // Flag span as changed
     show(void),                             // Issue color data to strip
+    showEncoded(const uint8_t *buf,         // Issue pre-encoded frame,
+                uint32_t len,               //  optionally in background
+                void (*done)(void) = NULL),
+    encode(uint8_t *dst) const,             // Encode frame into dst
     updatePins(void),                       // Change pin assignments (HW)
     updatePins(uint8_t d, uint8_t c),       // Change pin assignments (SW)
-    updateLength(uint16_t n);               // Change length
+    updateLength(uint16_t n),               // Change length
+    updateType(uint8_t o),                  // Change color order
+    setPowerModel(uint16_t mA_r,            // Per-channel mA at 255 and
+                  uint16_t mA_g,            //  per-pixel idle uA; all 0
+                  uint16_t mA_b,            //  turns power tracking off
+                  uint16_t idle_uA = 1000),
+    setPowerLimit(uint32_t mA),             // Supply budget, 0 = none
+    updatePower(void);                      // Resync after getPixels() use
   uint32_t
     getPixelColor(uint16_t n) const;        // Return 32-bit pixel color
   uint16_t
-    numPixels(void);                        // Return number of pixels
+    numPixels(void),                        // Return number of pixels
+    encodingVersion(void) const;            // Changes with encode settings
+  uint32_t
+    encodedLength(void) const,              // Bytes in an encoded frame
+    estimatedCurrent(void) const;           // mA drawn by next show()
+  boolean
+    isPowerLimited(void) const;             // Next show() scaled down?
+  boolean
+    setWireBuffer(boolean on = true);       // Keep encoded frame for show()
+#ifdef DOTSTAR_LINUX
+  boolean
+    isOpen(void) const;                     // Device opened by begin()?
+#endif
   uint8_t
     getBrightness(void) const,              // Return global brightness
    *getPixels(void) const;                  // Return pixel data pointer
@@ -178,11 +224,26 @@ class Adafruit_DotStar {
   void rainbow(uint16_t first_hue = 0, int8_t reps = 1,
                uint8_t saturation = 255, uint8_t brightness = 255,
                boolean gammify = true);
+  void noise(uint32_t x, uint32_t dx, uint32_t y = 0, uint32_t z = 0,
+             uint16_t first = 0, uint16_t count = 0,
+             uint16_t first_hue = 0, uint8_t saturation = 255,
+             uint8_t brightness = 255, boolean gammify = true);
 
  private:
 
   uint16_t
-    numLEDs;                                // Number of pixels
+    numLEDs,                                // Number of pixels
+    dirtyFirst,                             // First changed pixel
+    dirtyEnd,                               // One past last changed pixel
+    encVersion,                             // Bumped when encoding changes
+    wireScale,                              // Scale 'wire' was encoded at
+    chanMa[3],                              // mA for R,G,B at full value
+    idleUa;                                 // uA per pixel when dark
+  uint32_t
+    chanSum[3],                             // Sum of each pixel byte
+    powerLimit;                             // Budget in mA, 0 = none
+  boolean
+    powerOn;                                // chanSum[] being maintained
   uint8_t
     dataPin,                                // If soft SPI, data pin #
     clockPin,                               // If soft SPI, clock pin #
@@ -190,13 +251,38 @@ class Adafruit_DotStar {
    *pixels,                                 // LED RGB values (3 bytes ea.)
     rOffset,                                // Index of red in 3-byte pixel
     gOffset,                                // Index of green byte
-    bOffset;                                // Index of blue byte
+    bOffset,                                // Index of blue byte
+   *wire;                                   // Encoded APA102 frame, or NULL
+  uint16_t
+    output_scale(void) const;               // Brightness after limiting
+  uint32_t
+    color_current(void) const;              // mA of color at full scale
   void
+    encode_span(uint8_t *dst, uint16_t first, uint16_t end,
+                uint16_t scale) const,      // Pixels -> APA102 words
+    spi_write(const uint8_t *buf, uint32_t len,  // Bulk write to strip
+              void (*done)(void) = NULL),
     hw_spi_init(void),                      // Start hardware SPI
     hw_spi_end(void),                       // Stop hardware SPI
     sw_spi_init(void),                      // Start bitbang SPI
     sw_spi_out(uint8_t n),                  // Bitbang SPI write
     sw_spi_end(void);                       // Stop bitbang SPI
+#ifdef DOTSTAR_LINUX
+  void
+    linux_spi_init(void),                   // Open and set up spidev
+    linux_spi_write(const uint8_t *buf,     // Chunked spidev transfers
+                    uint32_t len),
+    linux_spi_end(void);                    // Close spidev
+  const char
+   *spiDevice;                              // Device (or file) path
+  int
+    spiFd;                                  // Open descriptor, -1 if not
+  uint32_t
+    spiHz,                                  // SPI clock
+    spiChunk;                               // Max bytes per transfer
+  boolean
+    spiIsDev;                               // Real spidev, not a file
+#endif
 #if (PLATFORM_ID == 32)
     void spi_out(int n);                    // SPI out
   SPIClass*
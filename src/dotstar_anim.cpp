@@ -0,0 +1,233 @@
+/*------------------------------------------------------------------------
+  Streaming playback of delta-compressed animations for the Particle
+  DotStar library.  See dotstar_anim.h.
+  ------------------------------------------------------------------------*/
+
+#include "dotstar_anim.h"
+#include "dotstar_compat.h"
+
+#if HAL_PLATFORM_FILESYSTEM || defined(DOTSTAR_LINUX)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// MEMORY SOURCE -----------------------------------------------------------
+
+DotStarAnimMemory::DotStarAnimMemory(const uint8_t *d, uint32_t l) :
+ data(d), len(l), pos(0) {
+}
+
+int DotStarAnimMemory::read(uint8_t *buf, uint16_t n) {
+  if (n > len - pos) n = len - pos;
+  memcpy(buf, &data[pos], n);
+  pos += n;
+  return n;
+}
+
+boolean DotStarAnimMemory::seek(uint32_t offset) {
+  if (offset > len) return false;
+  pos = offset;
+  return true;
+}
+
+// FILE SOURCE -------------------------------------------------------------
+
+#if HAL_PLATFORM_FILESYSTEM || defined(DOTSTAR_LINUX)
+DotStarAnimFile::DotStarAnimFile(void) : fd(-1) {
+}
+
+DotStarAnimFile::~DotStarAnimFile(void) {
+  close();
+}
+
+boolean DotStarAnimFile::open(const char *path) {
+  close();
+  fd = ::open(path, O_RDONLY);
+  return fd >= 0;
+}
+
+void DotStarAnimFile::close(void) {
+  if (fd >= 0) ::close(fd);
+  fd = -1;
+}
+
+int DotStarAnimFile::read(uint8_t *buf, uint16_t n) {
+  if (fd < 0) return -1;
+  return ::read(fd, buf, n);
+}
+
+boolean DotStarAnimFile::seek(uint32_t offset) {
+  if (fd < 0) return false;
+  return lseek(fd, offset, SEEK_SET) == (off_t)offset;
+}
+#endif // HAL_PLATFORM_FILESYSTEM || DOTSTAR_LINUX
+
+// PLAYER ------------------------------------------------------------------
+
+DotStarAnimPlayer::DotStarAnimPlayer(Adafruit_DotStar &s) :
+ strip(s), src(NULL), frameStart(0), frames(0), pixels(0), index(0),
+ duration(0), head(0), tail(0), looping(true), timed(false), eof(true) {
+}
+
+// Validate the header of an animation and position at its first frame.
+// Returns false if the source isn't a DotStar animation, or if its
+// frames are longer than the strip (they'd be cropped).  Shorter is
+// allowed and leaves the rest of the strip alone; compare numPixels()
+// with the strip if that matters.
+boolean DotStarAnimPlayer::begin(DotStarAnimSource &s, boolean loop) {
+  src      = &s;
+  looping  = loop;
+  frames   = 0;
+  pixels   = 0;
+  index    = 0;
+  timed    = false;
+  duration = 0;
+  head     = tail = 0;
+  eof      = !src->seek(0);
+  if (!refill(DSA_HEADER_SIZE)) {
+    src = NULL;
+    return false;
+  }
+  const uint8_t *h = &window[head];
+  if ((h[0] != DSA_MAGIC0) || (h[1] != DSA_MAGIC1) ||
+      (h[2] != DSA_MAGIC2) || (h[3] != DSA_MAGIC3)) {
+    src = NULL;
+    return false;
+  }
+  if ((uint16_t)(h[4] | (h[5] << 8)) > strip.numPixels()) {
+    src = NULL;
+    return false;
+  }
+  pixels = h[4] | (h[5] << 8);
+  frames = h[6] | (h[7] << 8);
+  head  += DSA_HEADER_SIZE;
+  return true;
+}
+
+void DotStarAnimPlayer::rewind(void) {
+  if (!src) return;
+  head  = tail = 0;
+  eof   = !src->seek(DSA_HEADER_SIZE);
+  index = 0;
+}
+
+// Ensure at least 'need' unread bytes are in the window, sliding any
+// leftovers to the front and topping up from the source.  Reads as much
+// as fits each time so small sources aren't hit once per op.
+boolean DotStarAnimPlayer::refill(uint16_t need) {
+  uint16_t avail = tail - head;
+  if (avail >= need) return true;
+  if (head) {
+    memmove(window, &window[head], avail);
+    head = 0;
+    tail = avail;
+  }
+  while ((tail < need) && !eof) {
+    int n = src->read(&window[tail], DOTSTAR_ANIM_WINDOW - tail);
+    if (n <= 0) eof = true;
+    else        tail += n;
+  }
+  return (tail - head) >= need;
+}
+
+// Pixel count for an op: the low six bits, or if those are 0, the
+// uint16 that follows.  Returns -1 if the data runs out.
+int32_t DotStarAnimPlayer::read_count(uint8_t op) {
+  uint8_t count = op & DSA_COUNT_MASK;
+  if (count) return count;
+  if (!refill(2)) return -1;
+  int32_t n = window[head] | (window[head + 1] << 8);
+  head += 2;
+  return n;
+}
+
+/*!
+  @brief   Decode the next frame into the strip's pixel buffer.  Only
+           pixels that differ from the previous frame are written (and
+           flagged dirty for show()).  At the end of the animation this
+           rewinds when looping, else returns false.
+  @return  true if a frame was decoded, false at end or on bad data.
+*/
+boolean DotStarAnimPlayer::nextFrame(void) {
+  if (!src) return false;
+  uint16_t held = duration;           // How long the last frame was due
+  if (index >= frames) {
+    if (!looping || !frames) return false;
+    rewind();
+  }
+  if (!refill(DSA_FRAME_HEADER)) return false;
+  duration = window[head + 1] | (window[head + 2] << 8);
+  head    += DSA_FRAME_HEADER;        // Flags don't change decoding
+
+  uint32_t pos = 0;                   // Next pixel the ops apply to
+  for (;;) {
+    if (!refill(1)) return false;
+    uint8_t op = window[head++];
+    if ((op & DSA_OP_MASK) == DSA_OP_END) break;
+    int32_t count = read_count(op);
+    if (count < 0) return false;
+    switch (op & DSA_OP_MASK) {
+     case DSA_OP_SKIP:
+      break;
+     case DSA_OP_COPY:                // Hand window contents straight over
+      for (int32_t left = count; left; ) {
+        if (!refill(3)) return false;
+        uint16_t n = (tail - head) / 3;
+        if (n > left) n = left;
+        if (pos <= 0xFFFF) strip.setPixels(pos, n, &window[head]);
+        head += n * 3;
+        pos  += n;
+        left -= n;
+      }
+      count = 0;                      // Already advanced above
+      break;
+     case DSA_OP_FILL:
+      if (!refill(3)) return false;
+      if (count && (pos <= 0xFFFF)) {
+        strip.fill(Adafruit_DotStar::Color(window[head], window[head + 1],
+          window[head + 2]), pos, count);
+      }
+      head += 3;
+      break;
+    }
+    pos += count;
+  }
+
+  index++;
+  // This frame was due 'held' ms after the last one.  Count from then,
+  // not from now, so decode time and loop() latency don't pile up into
+  // drift; if early (called by hand) or hopelessly late, start afresh.
+  uint32_t now  = millis();
+  int32_t  late = (int32_t)(now - (frameStart + held));
+  if (timed && (late >= 0) && (late <= DOTSTAR_ANIM_MAX_LATE)) {
+    frameStart += held;
+  } else {
+    frameStart  = now;
+  }
+  timed = true;
+  return true;
+}
+
+// Call often from loop(); decodes the next frame once the previous one
+// has been held for its duration.  Returns true when the strip changed
+// and show() should be called.
+boolean DotStarAnimPlayer::update(void) {
+  if (timed && ((millis() - frameStart) < duration)) return false;
+  return nextFrame();
+}
+
+uint16_t DotStarAnimPlayer::numFrames(void) const {
+  return frames;
+}
+
+uint16_t DotStarAnimPlayer::numPixels(void) const {
+  return pixels;
+}
+
+uint16_t DotStarAnimPlayer::frameIndex(void) const {
+  return index;
+}
+
+uint16_t DotStarAnimPlayer::frameDuration(void) const {
+  return duration;
+}
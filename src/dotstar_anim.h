@@ -0,0 +1,115 @@
+/*------------------------------------------------------------------------
+  Streaming playback of delta-compressed animations for the Particle
+  DotStar library.  See dotstar_anim_format.h for the file format and
+  tools/dsa-encode for the host-side encoder.
+
+  Frames are decoded straight into the strip from a small window that's
+  refilled from the source as needed, so animations much larger than RAM
+  can play from flash or the file system.  Only pixels that changed are
+  touched, and those are the only ones the next show() re-encodes.
+  ------------------------------------------------------------------------*/
+
+#ifndef _DOTSTAR_ANIM_H_
+#define _DOTSTAR_ANIM_H_
+
+#include "dotstar.h"
+#include "dotstar_anim_format.h"
+
+// Bytes of animation data buffered at once.  Must hold the file header
+// (DSA_HEADER_SIZE), the largest piece begin() or nextFrame() ever needs
+// in one go; more means fewer reads from the source.
+#ifndef DOTSTAR_ANIM_WINDOW
+#define DOTSTAR_ANIM_WINDOW 96
+#endif
+#if DOTSTAR_ANIM_WINDOW < DSA_HEADER_SIZE
+#error "DOTSTAR_ANIM_WINDOW must be at least DSA_HEADER_SIZE (12)"
+#endif
+
+// update() keeps frames on the schedule the durations set, absorbing
+// small delays in calling it; once this many ms behind, it gives up on
+// catching up and restarts the schedule from now.
+#ifndef DOTSTAR_ANIM_MAX_LATE
+#define DOTSTAR_ANIM_MAX_LATE 100
+#endif
+
+// Where animation bytes come from.  read() returns the number of bytes
+// copied (0 at end of data, negative on error); seek() positions at an
+// absolute byte offset from the start of the file.
+class DotStarAnimSource {
+ public:
+  virtual ~DotStarAnimSource(void) {}
+  virtual int     read(uint8_t *buf, uint16_t len) = 0;
+  virtual boolean seek(uint32_t offset) = 0;
+};
+
+// Animation held in memory, e.g. a const array compiled into flash.
+class DotStarAnimMemory : public DotStarAnimSource {
+ public:
+  DotStarAnimMemory(const uint8_t *data, uint32_t len);
+  int     read(uint8_t *buf, uint16_t len);
+  boolean seek(uint32_t offset);
+ private:
+  const uint8_t *data;
+  uint32_t       len, pos;
+};
+
+#if HAL_PLATFORM_FILESYSTEM || defined(DOTSTAR_LINUX)
+// Animation stored on the device file system.
+class DotStarAnimFile : public DotStarAnimSource {
+ public:
+  DotStarAnimFile(void);
+  ~DotStarAnimFile(void);
+  boolean open(const char *path);
+  void    close(void);
+  int     read(uint8_t *buf, uint16_t len);
+  boolean seek(uint32_t offset);
+ private:
+  int fd;
+};
+#endif // HAL_PLATFORM_FILESYSTEM || DOTSTAR_LINUX
+
+class DotStarAnimPlayer {
+
+ public:
+  DotStarAnimPlayer(Adafruit_DotStar &strip);
+  boolean
+    begin(DotStarAnimSource &src,           // Read header, rewind; false if
+          boolean loop = true),             //  not DSA or too many pixels
+    nextFrame(void),                        // Decode one frame into strip
+    update(void);                           // nextFrame() when one is due
+  void
+    rewind(void);                           // Restart at the first frame
+  uint16_t
+    numFrames(void) const,                  // Frames in the animation
+    numPixels(void) const,                  // Pixels per frame (header)
+    frameIndex(void) const,                 // Index of next frame
+    frameDuration(void) const;              // ms to hold last frame
+
+ private:
+
+  Adafruit_DotStar
+   &strip;
+  DotStarAnimSource
+   *src;
+  uint32_t
+    frameStart;                             // millis() last frame was due
+  uint16_t
+    frames,                                 // Frame count from header
+    pixels,                                 // Pixels per frame, header
+    index,                                  // Next frame to decode
+    duration,                               // Duration of last frame
+    head,                                   // Next unread window byte
+    tail;                                   // End of valid window bytes
+  boolean
+    looping,                                // Rewind at end of file
+    timed,                                  // frameStart is set
+    eof;                                    // Source has no more data
+  uint8_t
+    window[DOTSTAR_ANIM_WINDOW];            // Streaming read buffer
+  boolean
+    refill(uint16_t need);                  // Make 'need' bytes available
+  int32_t
+    read_count(uint8_t op);                 // Count from op (+ uint16)
+};
+
+#endif // _DOTSTAR_ANIM_H_
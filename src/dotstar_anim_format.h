@@ -0,0 +1,58 @@
+/*------------------------------------------------------------------------
+  Compact animation container for the Particle DotStar library.
+
+  Shared by the on-device player (dotstar_anim.h) and the host-side
+  encoder (tools/dsa-encode), so this header must only depend on the
+  C standard library.
+
+  File layout, all multi-byte fields little-endian:
+
+  HEADER (12 bytes)
+     0  'D','S','A','1'   Magic
+     4  uint16            Number of pixels per frame
+     6  uint16            Number of frames
+     8  uint16            Keyframe interval (0 = first frame only)
+    10  uint16            Reserved, write 0
+
+  FRAME (repeated for each frame)
+     0  uint8             Flags (DSA_FRAME_KEY)
+     1  uint16            Frame duration in milliseconds
+     3  ops...            Terminated by a DSA_OP_END byte
+
+  Each op is one byte: the top two bits select the op, the low six bits
+  are a pixel count of 1-63.  A count of 0 means a uint16 count follows
+  the op byte instead.  Ops walk the strip from pixel 0 upward:
+
+    DSA_OP_SKIP  Pixels unchanged from the previous frame
+    DSA_OP_COPY  'count' literal pixels follow, 3 bytes each (R,G,B)
+    DSA_OP_FILL  One R,G,B triplet follows, repeated 'count' times
+    DSA_OP_END   End of frame; any remaining pixels are unchanged
+
+  Keyframes contain no SKIP ops, so they decode correctly without the
+  previous frame; the first frame is always a keyframe, which is what
+  makes looping back to the start valid.  Pixel data is always stored
+  R,G,B regardless of the strip's color order.
+  ------------------------------------------------------------------------*/
+
+#ifndef _DOTSTAR_ANIM_FORMAT_H_
+#define _DOTSTAR_ANIM_FORMAT_H_
+
+#include <stdint.h>
+
+#define DSA_MAGIC0        'D'
+#define DSA_MAGIC1        'S'
+#define DSA_MAGIC2        'A'
+#define DSA_MAGIC3        '1'
+#define DSA_HEADER_SIZE   12
+#define DSA_FRAME_HEADER  3
+
+#define DSA_FRAME_KEY     0x01 // Frame decodes without the previous one
+
+#define DSA_OP_MASK       0xC0
+#define DSA_OP_SKIP       0x00
+#define DSA_OP_COPY       0x40
+#define DSA_OP_FILL       0x80
+#define DSA_OP_END        0xC0
+#define DSA_COUNT_MASK    0x3F // 0 = uint16 count follows op byte
+
+#endif // _DOTSTAR_ANIM_FORMAT_H_
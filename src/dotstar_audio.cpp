@@ -0,0 +1,284 @@
+/*------------------------------------------------------------------------
+  Audio-reactive analysis for the Particle DotStar library.
+  See dotstar_audio.h.
+  ------------------------------------------------------------------------*/
+
+#include <math.h>
+
+#include "dotstar_audio.h"
+#include "dotstar_fx.h"
+
+#if HAL_PLATFORM_FILESYSTEM || defined(DOTSTAR_LINUX)
+#include <unistd.h>
+#endif
+
+#define FFT_M (DOTSTAR_FFT_SIZE / 2) // Complex points in the packed FFT
+
+DotStarAudio::DotStarAudio(void) :
+ map(NULL), dc(2048L << 8), fill(0), oddByte(-1), bands(0), mapEntries(0) {
+  setRange();
+  setSmoothing();
+  setBands(16, 20000);
+}
+
+/*!
+  @brief   Divide the spectrum into log-spaced bands (equal width in
+           octaves), each at least one FFT bin wide.  Resets levels.
+  @param   n           Number of bands, 1 to DOTSTAR_AUDIO_MAX_BANDS.
+  @param   sampleRate  Input sample rate in Hz.
+  @param   minHz       Low edge of the first band; the last band ends at
+                       sampleRate / 2.
+*/
+void DotStarAudio::setBands(uint8_t n, uint32_t sampleRate, uint16_t minHz) {
+  if (n > DOTSTAR_AUDIO_MAX_BANDS) n = DOTSTAR_AUDIO_MAX_BANDS;
+  if (n > FFT_M - 1)               n = FFT_M - 1;
+  if (!n)                          n = 1;
+  bands = n;
+  // Float is fine here: it's once at setup, not per block
+  float binHz = (float)sampleRate / DOTSTAR_FFT_SIZE;
+  float ratio = (sampleRate / 2.0f) / (minHz ? minHz : 1);
+  for (uint8_t i = 0; i <= n; i++) {
+    float    hz  = minHz * powf(ratio, (float)i / n);
+    uint16_t bin = (uint16_t)(hz / binHz + 0.5f);
+    if (bin < 1)                  bin = 1;         // Skip DC
+    if (i && (bin <= edge[i - 1])) bin = edge[i - 1] + 1;
+    if (bin > FFT_M - (n - i))    bin = FFT_M - (n - i);
+    edge[i] = bin;
+  }
+  memset(levels, 0, sizeof(levels));
+  memset(peaks,  0, sizeof(peaks));
+}
+
+void DotStarAudio::setRange(uint8_t floor, uint8_t ceiling) {
+  lo = floor;
+  hi = (ceiling > floor) ? ceiling : floor + 1;
+}
+
+void DotStarAudio::setSmoothing(uint8_t d, uint8_t pd) {
+  decay     = d;
+  peakDecay = pd;
+}
+
+// The table isn't copied; keep it around (e.g. const, in flash).
+void DotStarAudio::setMap(const DotStarBandMap *m, uint8_t entries) {
+  map        = m;
+  mapEntries = entries;
+}
+
+/*!
+  @brief   Add signed 16-bit samples.  Each time DOTSTAR_FFT_SIZE have
+           accumulated they're analyzed, so pass blocks of any size.
+  @return  true if band levels were updated.
+*/
+boolean DotStarAudio::feed(const int16_t *pcm, uint16_t count) {
+  boolean updated = false;
+  while (count--) {
+    block[fill++] = *pcm++;
+    if (fill == DOTSTAR_FFT_SIZE) {
+      analyze();
+      fill    = 0;
+      updated = true;
+    }
+  }
+  return updated;
+}
+
+/*!
+  @brief   Add raw 12-bit ADC readings (0-4095), e.g. the finished half
+           of a DMA double buffer.  Device OS has no ADC DMA API, so
+           hand the buffer over from loop() once the DMA half/complete
+           interrupt has flagged it, rather than from the interrupt.
+           The microphone's DC bias is tracked and removed.
+  @return  true if band levels were updated.
+*/
+boolean DotStarAudio::feedADC(const uint16_t *adc, uint16_t count) {
+  int16_t  pcm[32];
+  boolean  updated = false;
+  while (count) {
+    uint16_t n = (count < 32) ? count : 32;
+    for (uint16_t i = 0; i < n; i++) {
+      int32_t s = ((int32_t)adc[i] << 8) - dc;
+      dc += s >> 10;                   // Slow high-pass, ~1/1024 per sample
+      s >>= 4;                         // 12.8 -> 16 bits
+      pcm[i] = (s > 32767) ? 32767 : (s < -32768) ? -32768 : s;
+    }
+    updated |= feed(pcm, n);
+    adc   += n;
+    count -= n;
+  }
+  return updated;
+}
+
+#if HAL_PLATFORM_FILESYSTEM || defined(DOTSTAR_LINUX)
+/*!
+  @brief   Read up to one block's worth of raw little-endian signed
+           16-bit mono PCM from a file descriptor and feed() it.  Handy
+           for testing against recordings, files or pipes.  Pipes and
+           FIFOs may return an odd number of bytes; the spare byte is
+           kept and paired up on the next call, so samples stay aligned.
+           Blocks (on a blocking fd) until at least one whole sample.
+  @return  Samples fed, 0 at end of file, negative on error.
+*/
+int DotStarAudio::feedFile(int fd) {
+  uint8_t  buf[DOTSTAR_FFT_SIZE * 2];
+  uint16_t have = 0;
+  if (oddByte >= 0) {                  // Low byte left from last time
+    buf[have++] = oddByte;
+    oddByte     = -1;
+  }
+  do {                                 // At least one whole sample
+    int n = read(fd, &buf[have], sizeof(buf) - have);
+    if (n <= 0) {
+      if (have) oddByte = buf[0];      // Keep it for a later call
+      return n;
+    }
+    have += n;
+  } while (have < 2);
+  if (have & 1) oddByte = buf[--have];
+
+  int16_t  pcm[32];
+  uint16_t samples = have / 2;
+  for (uint16_t i = 0; i < samples; ) {
+    uint16_t n = (samples - i < 32) ? samples - i : 32;
+    for (uint16_t j = 0; j < n; j++, i++) {
+      pcm[j] = (int16_t)(buf[i * 2] | (buf[i * 2 + 1] << 8));
+    }
+    feed(pcm, n);
+  }
+  return samples;
+}
+#endif // HAL_PLATFORM_FILESYSTEM || DOTSTAR_LINUX
+
+// Radix-2 decimation-in-time FFT over re[]/im[] in place, FFT_M points.
+// Every stage halves its outputs, so results are scaled by 1/FFT_M and
+// nothing can overflow as long as inputs fit in +/-16384 per component.
+void DotStarAudio::fft(void) {
+  for (uint16_t i = 1, j = 0; i < FFT_M; i++) {  // Bit-reversal permute
+    uint16_t bit = FFT_M >> 1;
+    for (; j & bit; bit >>= 1) j ^= bit;
+    j ^= bit;
+    if (i < j) {
+      int16_t t;
+      t = re[i]; re[i] = re[j]; re[j] = t;
+      t = im[i]; im[i] = im[j]; im[j] = t;
+    }
+  }
+  for (uint16_t len = 2; len <= FFT_M; len <<= 1) {
+    uint16_t half = len >> 1, step = 65536UL / len;
+    for (uint16_t k = 0; k < half; k++) {
+      int32_t wr =  DotStarFX::cos16(k * step);  // e^(-2 pi i k / len)
+      int32_t wi = -DotStarFX::sin16(k * step);
+      for (uint16_t i = k; i < FFT_M; i += len) {
+        uint16_t j  = i + half;
+        int32_t  tr = (wr * re[j] - wi * im[j]) >> 15;
+        int32_t  ti = (wr * im[j] + wi * re[j]) >> 15;
+        re[j] = (re[i] - tr) >> 1;
+        im[j] = (im[i] - ti) >> 1;
+        re[i] = (re[i] + tr) >> 1;
+        im[i] = (im[i] + ti) >> 1;
+      }
+    }
+  }
+}
+
+// Integer log2 in 1/16 octave steps: 16 * log2(x), 0 for x < 1.
+static uint8_t log2_q4(uint32_t x) {
+  if (!x) return 0;
+  uint8_t e = 31 - __builtin_clz(x);
+  uint8_t f = (e >= 4) ? (x >> (e - 4)) & 15 : (x << (4 - e)) & 15;
+  uint16_t l = e * 16 + f;
+  return (l > 255) ? 255 : l;
+}
+
+void DotStarAudio::analyze(void) {
+  // Hann window, halve (FFT headroom), and pack the N real samples as
+  // N/2 complex ones: even samples real, odd imaginary
+  for (uint16_t n = 0; n < DOTSTAR_FFT_SIZE; n++) {
+    uint32_t w = 32768 - DotStarFX::cos16(n * (65536UL / DOTSTAR_FFT_SIZE));
+    int16_t  s = ((int32_t)block[n] * (int32_t)w) >> 17;
+    if (n & 1) im[n >> 1] = s;
+    else       re[n >> 1] = s;
+  }
+
+  fft();
+
+  // Split the packed result into the real signal's spectrum,
+  //   X[k] = E[k] - i W^k O[k], W = e^(-2 pi i / N)
+  // and keep only magnitudes, written back over re[] (bin 0, DC, is
+  // dropped).  Bins k and M-k are done as a pair since each needs the
+  // other's inputs.
+  for (uint16_t k = 1; k <= FFT_M / 2; k++) {
+    uint16_t m = FFT_M - k;
+    int32_t  mag[2];
+    for (uint8_t pass = 0; pass < 2; pass++) {
+      uint16_t a = pass ? m : k, b = pass ? k : m;
+      int32_t  er = (re[a] + re[b]) >> 1, ei = (im[a] - im[b]) >> 1;
+      int32_t  or_ = (re[a] - re[b]) >> 1, oi = (im[a] + im[b]) >> 1;
+      uint16_t theta = a * (65536UL / DOTSTAR_FFT_SIZE);
+      int32_t  c = DotStarFX::cos16(theta), s = DotStarFX::sin16(theta);
+      int32_t  xr = er + ((oi * c - or_ * s) >> 15);
+      int32_t  xi = ei - ((oi * s + or_ * c) >> 15);
+      // |X| ~= max + 0.4 * min (alpha max plus beta min, <4% error)
+      if (xr < 0) xr = -xr;
+      if (xi < 0) xi = -xi;
+      mag[pass] = (xr > xi) ? (xr * 123 + xi * 51) >> 7
+                            : (xi * 123 + xr * 51) >> 7;
+    }
+    re[k] = (mag[0] > 32767) ? 32767 : mag[0];
+    re[m] = (mag[1] > 32767) ? 32767 : mag[1];
+  }
+
+  // Loudest bin in each band, to log scale, then attack/decay smoothing
+  for (uint8_t b = 0; b < bands; b++) {
+    int16_t peakBin = 0;
+    for (uint16_t k = edge[b]; k < edge[b + 1]; k++) {
+      if (re[k] > peakBin) peakBin = re[k];
+    }
+    int16_t l = log2_q4(peakBin);
+    l = (l <= lo) ? 0 : (l >= hi) ? 255 : (l - lo) * 255 / (hi - lo);
+    levels[b] = (l >= levels[b]) ? l :           // Instant attack
+                (levels[b] > l + decay) ? levels[b] - decay : l;
+    if (levels[b] >= peaks[b])    peaks[b] = levels[b];
+    else if (peaks[b] > peakDecay) peaks[b] -= peakDecay;
+    else                           peaks[b] = 0;
+  }
+}
+
+/*!
+  @brief   Draw every entry of the mapping table into the strip.  Pixels
+           not covered by the table are left alone.
+*/
+void DotStarAudio::render(Adafruit_DotStar &strip) {
+  for (uint8_t e = 0; e < mapEntries; e++) {
+    const DotStarBandMap *m = &map[e];
+    if ((m->band >= bands) || !m->count) continue;
+    uint16_t l = levels[m->band] + 1;  // 1-256 for >> 8 scaling
+    uint8_t  r = m->color >> 16, g = m->color >> 8, b = m->color;
+    if (m->mode == DOTSTAR_MAP_BAR) {
+      uint16_t lit  = ((uint32_t)m->count * levels[m->band] + 127) / 255;
+      uint16_t peak = ((uint32_t)(m->count - 1) * peaks[m->band]) / 255;
+      strip.fill(0, m->first, m->count);
+      if (lit)            strip.fill(m->color, m->first, lit);
+      if (peaks[m->band]) strip.setPixelColor(m->first + peak, m->color);
+    } else {
+      strip.fill(Adafruit_DotStar::Color((r * l) >> 8, (g * l) >> 8,
+                 (b * l) >> 8), m->first, m->count);
+    }
+  }
+}
+
+uint8_t DotStarAudio::numBands(void) const {
+  return bands;
+}
+
+uint8_t DotStarAudio::level(uint8_t band) const {
+  return (band < bands) ? levels[band] : 0;
+}
+
+uint8_t DotStarAudio::peak(uint8_t band) const {
+  return (band < bands) ? peaks[band] : 0;
+}
+
+uint16_t DotStarAudio::bandEdge(uint8_t i) const {
+  return (i <= bands) ? edge[i] : 0;
+}
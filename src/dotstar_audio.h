@@ -0,0 +1,114 @@
+/*------------------------------------------------------------------------
+  Audio-reactive analysis for the Particle DotStar library.
+
+  Blocks of samples go in (from an ADC, DMA-filled buffer or a file of
+  raw PCM), a fixed-point real FFT runs once per DOTSTAR_FFT_SIZE
+  samples, and the spectrum is reduced to a handful of log-spaced bands
+  with fast-attack, slow-decay smoothing and peak hold.  render() then
+  paints each band onto its pixel span per a mapping table.
+
+  CYCLE BUDGET (DOTSTAR_FFT_SIZE 256, per block, estimated from op
+  counts for single-cycle-multiply Cortex-M3/M4; not cycle-measured):
+    Hann window + packing      256 samples     ~1.5k cycles
+    128-point complex FFT      448 butterflies ~11k
+    Real-spectrum split        127 bins        ~4k
+    Magnitudes                 127 bins        ~1.5k
+    Bands, log scale, smoothing                ~1k
+    Total                                      ~19k cycles
+  That's about 160 us at 120 MHz (Photon/P1) or 300 us at 64 MHz (Argon
+  etc.), against a block period of 12.8 ms at 20 kHz sampling: roughly
+  1-3% of the CPU, leaving the rest for rendering and show().  Cost
+  scales with N log N; DOTSTAR_FFT_SIZE 512 is a little over double.
+
+  The FFT scales by 1/2 every stage so it can't overflow; a full-scale
+  sine lands around 8000 in its bin.  Levels are log2 of magnitude in
+  1/16 octave steps, mapped to 0-255 between setRange()'s floor and
+  ceiling.
+  ------------------------------------------------------------------------*/
+
+#ifndef _DOTSTAR_AUDIO_H_
+#define _DOTSTAR_AUDIO_H_
+
+#include "dotstar.h"
+
+// Samples per FFT block, a power of two (128-512)
+#ifndef DOTSTAR_FFT_SIZE
+#define DOTSTAR_FFT_SIZE 256
+#endif
+
+// Upper limit on setBands()
+#ifndef DOTSTAR_AUDIO_MAX_BANDS
+#define DOTSTAR_AUDIO_MAX_BANDS 32
+#endif
+
+// How a mapping table entry draws its band (DotStarBandMap 'mode'):
+#define DOTSTAR_MAP_LEVEL 0 // Whole span, brightness follows level
+#define DOTSTAR_MAP_BAR   1 // Bar graph from 'first', plus peak pixel
+
+struct DotStarBandMap {
+  uint8_t  band;                            // Band index
+  uint8_t  mode;                            // DOTSTAR_MAP_LEVEL or _BAR
+  uint16_t first;                           // First pixel of span
+  uint16_t count;                           // Pixels in span
+  uint32_t color;                           // Packed RGB at full level
+};
+
+class DotStarAudio {
+
+ public:
+  DotStarAudio(void);
+  void
+    setBands(uint8_t bands,                 // Log-spaced from minHz up to
+             uint32_t sampleRate,           //  sampleRate / 2
+             uint16_t minHz = 60),
+    setRange(uint8_t floor = 48,            // Log level shown as 0, 255
+             uint8_t ceiling = 208),
+    setSmoothing(uint8_t decay = 8,         // Level lost per block
+                 uint8_t peakDecay = 2),    // Peak lost per block
+    setMap(const DotStarBandMap *map,       // Bands -> pixel spans
+           uint8_t entries),
+    render(Adafruit_DotStar &strip);        // Draw mapped bands
+  boolean
+    feed(const int16_t *pcm, uint16_t count), // Signed 16-bit samples
+    feedADC(const uint16_t *adc,            // 12-bit ADC readings; DC
+            uint16_t count);                //  offset removed for you
+#if HAL_PLATFORM_FILESYSTEM || defined(DOTSTAR_LINUX)
+  int
+    feedFile(int fd);                       // Raw s16le PCM from a file
+#endif
+  uint8_t
+    numBands(void) const,
+    level(uint8_t band) const,              // Smoothed level, 0-255
+    peak(uint8_t band) const;               // Peak-hold level, 0-255
+  uint16_t
+    bandEdge(uint8_t i) const;              // First FFT bin of band i
+
+ private:
+
+  const DotStarBandMap
+   *map;
+  int32_t
+    dc;                                     // feedADC() offset, 12.8
+  uint16_t
+    fill,                                   // Samples in 'block'
+    edge[DOTSTAR_AUDIO_MAX_BANDS + 1];      // First bin of each band
+  int16_t
+    oddByte,                                // feedFile() half sample, or -1
+    block[DOTSTAR_FFT_SIZE],                // Incoming samples
+    re[DOTSTAR_FFT_SIZE / 2],               // FFT work, then magnitudes
+    im[DOTSTAR_FFT_SIZE / 2];
+  uint8_t
+    bands,
+    mapEntries,
+    lo,                                     // setRange() floor
+    hi,                                     // setRange() ceiling
+    decay,
+    peakDecay,
+    levels[DOTSTAR_AUDIO_MAX_BANDS],
+    peaks[DOTSTAR_AUDIO_MAX_BANDS];
+  void
+    analyze(void),                          // Process a full block
+    fft(void);                              // In-place complex FFT
+};
+
+#endif // _DOTSTAR_AUDIO_H_
@@ -0,0 +1,141 @@
+/*------------------------------------------------------------------------
+  Cache of fully-encoded frames for the Particle DotStar library.
+  See dotstar_cache.h.
+  ------------------------------------------------------------------------*/
+
+#include "dotstar_cache.h"
+
+DotStarFrameCache::DotStarFrameCache(Adafruit_DotStar &s, uint32_t b) :
+ strip(s), head(NULL), tail(NULL), budget(b), bytes(0), hitCount(0),
+ missCount(0), version(s.encodingVersion()) {
+}
+
+DotStarFrameCache::~DotStarFrameCache(void) {
+  clear();
+}
+
+void DotStarFrameCache::clear(void) {
+  while (head) {
+    Entry *e = head;
+    head = e->next;
+    free(e);
+  }
+  tail  = NULL;
+  bytes = 0;
+}
+
+void DotStarFrameCache::setBudget(uint32_t b) {
+  budget = b;
+  evict(0);
+}
+
+// Cached frames were encoded with the strip's brightness and color order
+// at the time; once either changes they're all wrong, so start over.
+void DotStarFrameCache::validate(void) {
+  uint16_t v = strip.encodingVersion();
+  if (v != version) {
+    clear();
+    version = v;
+  }
+}
+
+DotStarFrameCache::Entry *DotStarFrameCache::find(uint32_t id) {
+  for (Entry *e = head; e; e = e->next) {
+    if (e->id == id) return e;
+  }
+  return NULL;
+}
+
+void DotStarFrameCache::unlink(Entry *e) {
+  if (e->prev) e->prev->next = e->next;
+  else         head          = e->next;
+  if (e->next) e->next->prev = e->prev;
+  else         tail          = e->prev;
+}
+
+void DotStarFrameCache::push_front(Entry *e) {
+  e->prev = NULL;
+  e->next = head;
+  if (head) head->prev = e;
+  else      tail       = e;
+  head = e;
+}
+
+// Drop least-recently-used entries until 'need' more bytes fit.
+void DotStarFrameCache::evict(uint32_t need) {
+  while (tail && (bytes + need > budget)) {
+    Entry *e = tail;
+    unlink(e);
+    bytes -= sizeof(Entry) + e->len;
+    free(e);
+  }
+}
+
+boolean DotStarFrameCache::contains(uint32_t id) {
+  validate();
+  return find(id) != NULL;
+}
+
+/*!
+  @brief   Send the cached frame 'id' straight to the strip, skipping
+           all per-pixel work in show().  The strip's pixel buffer is
+           left untouched.
+  @param   id  Frame ID previously passed to store().
+  @return  true on a hit (frame sent), false on a miss (nothing sent;
+           render, show() and store() the frame as usual).
+*/
+boolean DotStarFrameCache::show(uint32_t id) {
+  validate();
+  Entry *e = find(id);
+  if (!e) {
+    missCount++;
+    return false;
+  }
+  if (e != head) {                     // Mark most recently used
+    unlink(e);
+    push_front(e);
+  }
+  hitCount++;
+  strip.showEncoded((const uint8_t *)(e + 1), e->len);
+  return true;
+}
+
+/*!
+  @brief   Encode the strip's current pixels and save them as frame 'id',
+           replacing any existing entry with that ID.
+  @param   id  Caller-chosen frame ID, e.g. frame number within a loop.
+  @return  false if the frame is larger than the budget or memory for it
+           could not be allocated.
+*/
+boolean DotStarFrameCache::store(uint32_t id) {
+  validate();
+  Entry *e = find(id);
+  if (e) {
+    unlink(e);
+    bytes -= sizeof(Entry) + e->len;
+    free(e);
+  }
+  uint32_t len  = strip.encodedLength();
+  uint32_t need = sizeof(Entry) + len;
+  if (need > budget) return false;
+  evict(need);
+  if (!(e = (Entry *)malloc(need))) return false;
+  e->id  = id;
+  e->len = len;
+  strip.encode((uint8_t *)(e + 1));
+  push_front(e);
+  bytes += need;
+  return true;
+}
+
+uint32_t DotStarFrameCache::used(void) const {
+  return bytes;
+}
+
+uint32_t DotStarFrameCache::hits(void) const {
+  return hitCount;
+}
+
+uint32_t DotStarFrameCache::misses(void) const {
+  return missCount;
+}
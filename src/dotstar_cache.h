@@ -0,0 +1,82 @@
+/*------------------------------------------------------------------------
+  Cache of fully-encoded frames for the Particle DotStar library.
+
+  Looping animations tend to produce the exact same frames every time
+  around.  Rather than re-scale and re-frame those pixels in show() on
+  each pass, store the encoded bytes (start frame, pixel words, end
+  frame) under a frame ID the first time and send them as-is afterward:
+
+    if (!cache.show(frame)) {  // Miss: render and show the slow way
+      render(frame);
+      strip.show();
+      cache.store(frame);
+    }
+
+  A hit skips render() entirely, so this only works if render(frame)
+  builds the whole frame from scratch, not from whatever the previous
+  frame left in the strip.  DotStarAnimPlayer is the opposite: each
+  frame is a delta that must be applied to the one before, in order.
+  With a player, keep decoding on every frame and use the cache only to
+  skip the encode:
+
+    player.nextFrame();        // Always, hit or miss
+    if (!cache.show(player.frameIndex())) {
+      strip.show();
+      cache.store(player.frameIndex());
+    }
+
+  Entries are evicted least-recently-used first to stay within the byte
+  budget given to the constructor.  Changing brightness, color order or
+  length on the strip automatically empties the cache.
+  ------------------------------------------------------------------------*/
+
+#ifndef _DOTSTAR_CACHE_H_
+#define _DOTSTAR_CACHE_H_
+
+#include "dotstar.h"
+
+class DotStarFrameCache {
+
+ public:
+  DotStarFrameCache(Adafruit_DotStar &strip, uint32_t budget);
+ ~DotStarFrameCache(void);
+  boolean
+    show(uint32_t id),                      // Send cached frame if present
+    store(uint32_t id),                     // Encode & cache strip as 'id'
+    contains(uint32_t id);                  // Cached (and still valid)?
+  void
+    clear(void),                            // Drop all entries
+    setBudget(uint32_t budget);             // Change byte budget
+  uint32_t
+    used(void) const,                       // Bytes in use incl. overhead
+    hits(void) const,                       // show() calls that hit
+    misses(void) const;                     // show() calls that missed
+
+ private:
+
+  struct Entry {
+    Entry    *prev, *next;                  // Most recently used first
+    uint32_t  id, len;                      // Encoded data follows struct
+  };
+  Adafruit_DotStar
+   &strip;
+  Entry
+   *head,                                   // Most recently used
+   *tail;                                   // Next to be evicted
+  uint32_t
+    budget,
+    bytes,
+    hitCount,
+    missCount;
+  uint16_t
+    version;                                // strip.encodingVersion() seen
+  Entry
+   *find(uint32_t id);
+  void
+    validate(void),                         // Flush if settings changed
+    unlink(Entry *e),
+    push_front(Entry *e),
+    evict(uint32_t need);                   // Make room for 'need' bytes
+};
+
+#endif // _DOTSTAR_CACHE_H_
@@ -0,0 +1,37 @@
+/*------------------------------------------------------------------------
+  Arduino-style timing for Linux builds of the Particle DotStar library.
+
+  Device OS provides millis(), micros() and delay(); on Linux this
+  header does, for the library sources that need them and for sketches
+  that want them.  It's kept out of dotstar.h so programs that already
+  get these from wiringPi or another Arduino-compat layer can leave it
+  out.  Everywhere else it does nothing.
+  ------------------------------------------------------------------------*/
+
+#ifndef _DOTSTAR_COMPAT_H_
+#define _DOTSTAR_COMPAT_H_
+
+#include "dotstar.h"
+
+#ifdef DOTSTAR_LINUX
+#include <time.h>
+
+static inline uint32_t micros(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint32_t)ts.tv_sec * 1000000UL + ts.tv_nsec / 1000;
+}
+
+static inline uint32_t millis(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint32_t)ts.tv_sec * 1000UL + ts.tv_nsec / 1000000;
+}
+
+static inline void delay(uint32_t ms) {
+  struct timespec ts = { (time_t)(ms / 1000), (long)(ms % 1000) * 1000000L };
+  while (nanosleep(&ts, &ts));         // Resume if interrupted by a signal
+}
+#endif // DOTSTAR_LINUX
+
+#endif // _DOTSTAR_COMPAT_H_
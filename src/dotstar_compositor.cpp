@@ -0,0 +1,251 @@
+/*------------------------------------------------------------------------
+  Layer compositor for the Particle DotStar library.
+  See dotstar_compositor.h.
+  ------------------------------------------------------------------------*/
+
+#include "dotstar_compositor.h"
+
+DotStarCompositor::DotStarCompositor(Adafruit_DotStar &s, uint8_t n) :
+ strip(s), layers(NULL), spans(NULL), pixels(NULL), numLEDs(0), count(n) {
+}
+
+DotStarCompositor::~DotStarCompositor(void) {
+  if (layers) free(layers);
+  if (spans)  free(spans);
+  if (pixels) free(pixels);
+}
+
+/*!
+  @brief   Allocate the layers, one pixel per strip pixel, all fully
+           transparent, opacity 255 and DOTSTAR_LAYER_NORMAL.  Call again
+           after changing the strip's length (layer contents are lost).
+  @return  false if the memory couldn't be allocated.
+*/
+boolean DotStarCompositor::begin(void) {
+  if (layers) free(layers);
+  if (spans)  free(spans);
+  if (pixels) free(pixels);
+  numLEDs = strip.numPixels();
+  layers  = (Layer *)malloc(count * sizeof(Layer));
+  spans   = (Span *)malloc(count * sizeof(Span));
+  pixels  = (uint8_t *)malloc((uint32_t)count * numLEDs * 4);
+  if (!layers || !spans || !pixels) {
+    if (layers) free(layers);
+    if (spans)  free(spans);
+    if (pixels) free(pixels);
+    layers  = NULL;
+    spans   = NULL;
+    pixels  = NULL;
+    numLEDs = 0;
+    return false;
+  }
+  memset(pixels, 0, (uint32_t)count * numLEDs * 4);
+  for (uint8_t i = 0; i < count; i++) {
+    Layer *l      = &layers[i];
+    l->rgba       = &pixels[(uint32_t)i * numLEDs * 4];
+    l->dirtyFirst = 0;                 // Whole strip on first composite()
+    l->dirtyEnd   = numLEDs;
+    l->usedFirst  = l->usedEnd = 0;
+    l->opacity    = 255;
+    l->mode       = DOTSTAR_LAYER_NORMAL;
+  }
+  return true;
+}
+
+// Grow a layer's changed and drawn-into spans to include [first, end)
+void DotStarCompositor::touch(Layer *l, uint16_t first, uint16_t end) {
+  if (first >= end) return;
+  if (l->dirtyFirst >= l->dirtyEnd) {
+    l->dirtyFirst = first;
+    l->dirtyEnd   = end;
+  } else {
+    if (first < l->dirtyFirst) l->dirtyFirst = first;
+    if (end   > l->dirtyEnd)   l->dirtyEnd   = end;
+  }
+  if (l->usedFirst >= l->usedEnd) {
+    l->usedFirst = first;
+    l->usedEnd   = end;
+  } else {
+    if (first < l->usedFirst) l->usedFirst = first;
+    if (end   > l->usedEnd)   l->usedEnd   = end;
+  }
+}
+
+void DotStarCompositor::setPixelColor(uint8_t layer, uint16_t n, uint32_t c,
+  uint8_t alpha) {
+  if ((layer >= numLayers()) || (n >= numLEDs)) return;
+  Layer   *l = &layers[layer];
+  uint8_t *p = &l->rgba[n * 4];
+  p[0] = c >> 16;
+  p[1] = c >> 8;
+  p[2] = c;
+  p[3] = alpha;
+  touch(l, n, n + 1);
+}
+
+/*!
+  @brief   Copy a run of pixels into a layer.
+  @param   rgba  'count' pixels of 4 bytes each: R, G, B, alpha.
+*/
+void DotStarCompositor::setPixels(uint8_t layer, uint16_t first,
+  uint16_t n, const uint8_t *rgba) {
+  if ((layer >= numLayers()) || (first >= numLEDs)) return;
+  if (n > numLEDs - first) n = numLEDs - first;
+  Layer *l = &layers[layer];
+  memcpy(&l->rgba[first * 4], rgba, n * 4);
+  touch(l, first, first + n);
+}
+
+// Count 0 means to end of strip.
+void DotStarCompositor::fill(uint8_t layer, uint32_t c, uint8_t alpha,
+  uint16_t first, uint16_t n) {
+  if ((layer >= numLayers()) || (first >= numLEDs)) return;
+  if (!n || (n > numLEDs - first)) n = numLEDs - first;
+  Layer   *l = &layers[layer];
+  uint8_t *p = &l->rgba[first * 4];
+  uint8_t  r = c >> 16, g = c >> 8, b = c;
+  for (uint16_t i = 0; i < n; i++, p += 4) {
+    p[0] = r;
+    p[1] = g;
+    p[2] = b;
+    p[3] = alpha;
+  }
+  touch(l, first, first + n);
+}
+
+// Only the span the layer had drawn into needs recompositing.
+void DotStarCompositor::clear(uint8_t layer) {
+  if (layer >= numLayers()) return;
+  Layer *l = &layers[layer];
+  if (l->usedFirst >= l->usedEnd) return;
+  memset(&l->rgba[l->usedFirst * 4], 0, (l->usedEnd - l->usedFirst) * 4);
+  touch(l, l->usedFirst, l->usedEnd);
+  l->usedFirst = l->usedEnd = 0;
+}
+
+// Flag pixels as changed after writing them through getLayer().  Count
+// 0 means to end of strip.
+void DotStarCompositor::markDirty(uint8_t layer, uint16_t first,
+  uint16_t n) {
+  if ((layer >= numLayers()) || (first >= numLEDs)) return;
+  if (!n || (n > numLEDs - first)) n = numLEDs - first;
+  touch(&layers[layer], first, first + n);
+}
+
+void DotStarCompositor::setOpacity(uint8_t layer, uint8_t opacity) {
+  if ((layer >= numLayers()) || (layers[layer].opacity == opacity)) return;
+  Layer *l   = &layers[layer];
+  l->opacity = opacity;
+  touch(l, l->usedFirst, l->usedEnd);
+}
+
+void DotStarCompositor::setBlend(uint8_t layer, uint8_t mode) {
+  if ((layer >= numLayers()) || (layers[layer].mode == mode)) return;
+  Layer *l = &layers[layer];
+  l->mode  = mode;
+  touch(l, l->usedFirst, l->usedEnd);
+}
+
+uint32_t DotStarCompositor::getPixelColor(uint8_t layer, uint16_t n) const {
+  if ((layer >= numLayers()) || (n >= numLEDs)) return 0;
+  const uint8_t *p = &layers[layer].rgba[n * 4];
+  return ((uint32_t)p[0] << 16) | ((uint32_t)p[1] << 8) | p[2];
+}
+
+uint8_t DotStarCompositor::getAlpha(uint8_t layer, uint16_t n) const {
+  if ((layer >= numLayers()) || (n >= numLEDs)) return 0;
+  return layers[layer].rgba[n * 4 + 3];
+}
+
+uint8_t DotStarCompositor::getOpacity(uint8_t layer) const {
+  return (layer < numLayers()) ? layers[layer].opacity : 0;
+}
+
+uint8_t DotStarCompositor::numLayers(void) const {
+  return layers ? count : 0;
+}
+
+uint8_t *DotStarCompositor::getLayer(uint8_t layer) const {
+  return (layer < numLayers()) ? layers[layer].rgba : NULL;
+}
+
+/*!
+  @brief   Rebuild the strip pixels covered by any layer's changes since
+           the last composite(), and nothing else.
+*/
+void DotStarCompositor::composite(void) {
+  if (!layers) return;
+
+  // Changed spans of all layers, sorted by start (few layers, so an
+  // insertion sort is plenty)
+  uint8_t n = 0;
+  for (uint8_t i = 0; i < count; i++) {
+    Layer *l = &layers[i];
+    if (l->dirtyFirst >= l->dirtyEnd) continue;
+    uint8_t j = n++;
+    while (j && (spans[j - 1].first > l->dirtyFirst)) {
+      spans[j] = spans[j - 1];
+      j--;
+    }
+    spans[j].first = l->dirtyFirst;
+    spans[j].end   = l->dirtyEnd;
+    l->dirtyFirst  = l->dirtyEnd = 0;
+  }
+
+  // Merge overlapping or touching spans and rebuild each
+  for (uint8_t a = 0; a < n; ) {
+    uint16_t first = spans[a].first, end = spans[a].end;
+    for (a++; (a < n) && (spans[a].first <= end); a++) {
+      if (spans[a].end > end) end = spans[a].end;
+    }
+    composite_span(first, end);
+  }
+}
+
+void DotStarCompositor::show(void) {
+  composite();
+  strip.show();
+}
+
+// Composite pixels [first, end) from black upward, a chunk at a time.
+void DotStarCompositor::composite_span(uint16_t first, uint16_t end) {
+  uint8_t rgb[DOTSTAR_LAYER_CHUNK * 3];
+  for (uint16_t c0 = first; c0 < end; c0 += DOTSTAR_LAYER_CHUNK) {
+    uint16_t n = (end - c0 > DOTSTAR_LAYER_CHUNK) ?
+                 DOTSTAR_LAYER_CHUNK : end - c0;
+    memset(rgb, 0, n * 3);
+    for (uint8_t i = 0; i < count; i++) {
+      const Layer *l = &layers[i];
+      if (!l->opacity || (l->usedFirst >= c0 + n) ||
+          (l->usedEnd <= c0)) continue;  // Nothing to add here
+      blend_row(l, rgb, c0, n);
+    }
+    strip.setPixels(c0, n, rgb);
+  }
+}
+
+// Blend 'n' pixels of a layer, starting at pixel 'first', into 'rgb'.
+// Each pixel's weight is its alpha times the layer opacity, 0-256, and
+// the mode's result is mixed in by that weight.
+void DotStarCompositor::blend_row(const Layer *l, uint8_t *rgb,
+  uint16_t first, uint16_t n) {
+  const uint8_t *src = &l->rgba[first * 4];
+  uint16_t       op  = l->opacity + 1;
+  for (uint16_t i = 0; i < n; i++, src += 4, rgb += 3) {
+    uint16_t w = (src[3] * op) >> 8;
+    if (!w) continue;                    // Fully transparent
+    w += w >> 7;                         // 0-255 -> 0-256
+    for (uint8_t c = 0; c < 3; c++) {
+      uint16_t d = rgb[c], s = src[c], t;
+      if (l->mode == DOTSTAR_LAYER_ADD) {
+        t      = d + ((s * w) >> 8);
+        rgb[c] = (t > 255) ? 255 : t;
+        continue;
+      }
+      if (l->mode == DOTSTAR_LAYER_MULTIPLY) t = (d * (s + 1)) >> 8;
+      else if (l->mode == DOTSTAR_LAYER_MAX) t = (s > d) ? s : d;
+      else                                   t = s;
+      rgb[c] = (t * w + d * (256 - w)) >> 8;
+    }
+  }
+}
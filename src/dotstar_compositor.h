@@ -0,0 +1,101 @@
+/*------------------------------------------------------------------------
+  Layer compositor for the Particle DotStar library.
+
+  Keeps a stack of full-length RGBA layers (e.g. a background effect, a
+  status overlay and a transition on top) and combines them into the
+  strip, bottom layer first, each with its own opacity and blend mode.
+  Effects draw into their own layer and never need to read back what's
+  underneath.
+
+  Every layer tracks the span of pixels changed since the last
+  composite(), plus the span it has ever drawn into (so changing its
+  opacity or blend mode only touches that).  composite() merges the
+  changed spans of all layers and rebuilds just those pixels, a chunk at
+  a time, handing them to the strip with setPixels(); everything else is
+  left as it was.  The strip's own change tracking then carries that
+  through to show().
+
+    DotStarCompositor comp(strip, 3);
+    comp.begin();
+    comp.setBlend(2, DOTSTAR_LAYER_ADD);
+    comp.fill(1, 0xFF0000, 128, 0, 4);       // Half-transparent red alert
+    ...
+    comp.show();                             // composite() + strip.show()
+
+  RAM: 4 bytes per pixel per layer.
+  ------------------------------------------------------------------------*/
+
+#ifndef _DOTSTAR_COMPOSITOR_H_
+#define _DOTSTAR_COMPOSITOR_H_
+
+#include "dotstar.h"
+
+// Layer blend modes (see setBlend()).  All are mixed in by the pixel's
+// alpha times the layer's opacity.
+#define DOTSTAR_LAYER_NORMAL   0 // Layer color over what's below
+#define DOTSTAR_LAYER_ADD      1 // Sum, clipping at 255
+#define DOTSTAR_LAYER_MULTIPLY 2 // Product, darkens (white = no change)
+#define DOTSTAR_LAYER_MAX      3 // Brighter of the two per channel
+
+// Pixels composited per pass through the chunk buffer
+#define DOTSTAR_LAYER_CHUNK 32
+
+class DotStarCompositor {
+
+ public:
+  DotStarCompositor(Adafruit_DotStar &strip, uint8_t layers);
+ ~DotStarCompositor(void);
+  boolean
+    begin(void);                            // Allocate, sized to strip
+  void
+    setPixelColor(uint8_t layer, uint16_t n, uint32_t c,
+                  uint8_t alpha = 255),
+    setPixels(uint8_t layer, uint16_t first, // R,G,B,A bytes
+              uint16_t count, const uint8_t *rgba),
+    fill(uint8_t layer, uint32_t c = 0, uint8_t alpha = 255,
+         uint16_t first = 0, uint16_t count = 0),
+    clear(uint8_t layer),                   // Make layer fully transparent
+    markDirty(uint8_t layer,                // After writing getLayer()
+              uint16_t first, uint16_t count),
+    setOpacity(uint8_t layer, uint8_t opacity),
+    setBlend(uint8_t layer, uint8_t mode),
+    composite(void),                        // Update strip from layers
+    show(void);                             // composite(), strip.show()
+  uint32_t
+    getPixelColor(uint8_t layer, uint16_t n) const; // Packed RGB
+  uint8_t
+    getAlpha(uint8_t layer, uint16_t n) const,
+    getOpacity(uint8_t layer) const,
+    numLayers(void) const,
+   *getLayer(uint8_t layer) const;          // Raw R,G,B,A per pixel
+
+ private:
+
+  struct Layer {
+    uint8_t  *rgba;                         // 4 bytes per pixel
+    uint16_t  dirtyFirst, dirtyEnd;         // Changed since composite()
+    uint16_t  usedFirst,  usedEnd;          // Ever drawn since clear()
+    uint8_t   opacity, mode;
+  };
+  struct Span {
+    uint16_t  first, end;
+  };
+  Adafruit_DotStar
+   &strip;
+  Layer
+   *layers;
+  Span
+   *spans;                                  // Scratch for composite()
+  uint8_t
+   *pixels;                                 // All layers' RGBA data
+  uint16_t
+    numLEDs;
+  uint8_t
+    count;                                  // Number of layers
+  void
+    touch(Layer *l, uint16_t first, uint16_t end), // Mark changed
+    composite_span(uint16_t first, uint16_t end),
+    blend_row(const Layer *l, uint8_t *rgb, uint16_t first, uint16_t n);
+};
+
+#endif // _DOTSTAR_COMPOSITOR_H_
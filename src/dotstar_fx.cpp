@@ -0,0 +1,173 @@
+/*------------------------------------------------------------------------
+  Fixed-point effect math for the Particle DotStar library.
+  See dotstar_fx.h.
+  ------------------------------------------------------------------------*/
+
+#include "dotstar_fx.h"
+
+/* Ken Perlin's reference permutation of 0-255, used to hash lattice
+   coordinates for both kinds of noise. */
+static const uint8_t PROGMEM _DotStarPermTable[256] = {
+    151, 160, 137,  91,  90,  15, 131,  13, 201,  95,  96,  53, 194, 233,   7,
+    225, 140,  36, 103,  30,  69, 142,   8,  99,  37, 240,  21,  10,  23, 190,
+      6, 148, 247, 120, 234,  75,   0,  26, 197,  62,  94, 252, 219, 203, 117,
+     35,  11,  32,  57, 177,  33,  88, 237, 149,  56,  87, 174,  20, 125, 136,
+    171, 168,  68, 175,  74, 165,  71, 134, 139,  48,  27, 166,  77, 146, 158,
+    231,  83, 111, 229, 122,  60, 211, 133, 230, 220, 105,  92,  41,  55,  46,
+    245,  40, 244, 102, 143,  54,  65,  25,  63, 161,   1, 216,  80,  73, 209,
+     76, 132, 187, 208,  89,  18, 169, 200, 196, 135, 130, 116, 188, 159,  86,
+    164, 100, 109, 198, 173, 186,   3,  64,  52, 217, 226, 250, 124, 123,   5,
+    202,  38, 147, 118, 126, 255,  82,  85, 212, 207, 206,  59, 227,  47,  16,
+     58,  17, 182, 189,  28,  42, 223, 183, 170, 213, 119, 248, 152,   2,  44,
+    154, 163,  70, 221, 153, 101, 155, 167,  43, 172,   9, 129,  22,  39, 253,
+     19,  98, 108, 110,  79, 113, 224, 232, 178, 185, 112, 104, 218, 246,  97,
+    228, 251,  34, 242, 193, 238, 210, 144,  12, 191, 179, 162, 241,  81,  51,
+    145, 235, 249,  14, 239, 107,  49, 192, 214,  31, 181, 199, 106, 157, 184,
+     84, 204, 176, 115, 121,  50,  45, 127,   4, 150, 254, 138, 236, 205,  93,
+    222, 114,  67,  29,  24,  72, 243, 141, 128, 195,  78,  66, 215,  61, 156,
+    180};
+
+#define P(x) pgm_read_byte(&_DotStarPermTable[(uint8_t)(x)])
+
+uint16_t DotStarFX::beatsin16(uint16_t bpm, uint16_t lo, uint16_t hi,
+  uint32_t ms, uint16_t phase) {
+  uint16_t s = sin16(beat16(bpm, ms) + phase) + 32768;
+  return lo + (((uint32_t)s * (hi - lo + 1)) >> 16);
+}
+
+uint8_t DotStarFX::beatsin8(uint16_t bpm, uint8_t lo, uint8_t hi,
+  uint32_t ms, uint8_t phase) {
+  uint8_t s = (sin16(beat16(bpm, ms) + (phase << 8)) + 32768) >> 8;
+  return lo + ((s * (hi - lo + 1)) >> 8);
+}
+
+// NOISE --------------------------------------------------------------------
+
+// Smoothstep (3t^2 - 2t^3) of a 16-bit fraction.  Keeps noise continuous
+// across lattice cells without the cost of Perlin's quintic.
+static inline uint32_t ease16(uint32_t t) {
+  uint32_t t2 = (t * t) >> 16;
+  return 3 * t2 - 2 * ((t2 * t) >> 16);
+}
+
+// Interpolate a->b by a 16-bit fraction.  |b-a| must stay under 32768.
+static inline int32_t lerp16(int32_t a, int32_t b, uint32_t t) {
+  return a + (((b - a) * (int32_t)t) >> 16);
+}
+
+// Dot product of one of Perlin's 12 edge gradients (picked by the hash)
+// with the offset x,y,z from its lattice corner, all 4.12 fixed point.
+static inline int32_t grad(uint8_t h, int32_t x, int32_t y, int32_t z) {
+  h &= 15;
+  int32_t u = (h < 8) ? x : y;
+  int32_t v = (h < 4) ? y : (((h == 12) || (h == 14)) ? x : z);
+  return ((h & 1) ? -u : u) + ((h & 2) ? -v : v);
+}
+
+// Noise results span roughly -4096 to +4096; stretch to the full 16 bits.
+static inline uint16_t to_u16(int32_t n) {
+  n = n * 8 + 32768;
+  return (n < 0) ? 0 : (n > 65535) ? 65535 : n;
+}
+
+/*!
+  @brief   3D gradient ("Perlin") noise.
+  @param   x,y,z  Coordinates, 16.16 fixed point.  Leave y and/or z 0 for
+                  1D or 2D noise.
+  @return  Noise value 0-65535, centered on 32768.  Values near the ends
+           are rare; scale or contrast-stretch to taste.
+*/
+uint16_t DotStarFX::noise16(uint32_t x, uint32_t y, uint32_t z) {
+  uint8_t  X  = x >> 16, Y = y >> 16, Z = z >> 16;
+  uint32_t fx = x & 0xFFFF, fy = y & 0xFFFF, fz = z & 0xFFFF;
+  uint32_t u  = ease16(fx), v = ease16(fy), w = ease16(fz);
+  int32_t  x0 = fx >> 4, y0 = fy >> 4, z0 = fz >> 4; // 4.12 offsets
+  int32_t  x1 = x0 - 4096, y1 = y0 - 4096, z1 = z0 - 4096;
+
+  uint8_t A  = P(X) + Y,     B  = P(X + 1) + Y;
+  uint8_t AA = P(A) + Z,     AB = P(A + 1) + Z;
+  uint8_t BA = P(B) + Z,     BB = P(B + 1) + Z;
+
+  return to_u16(
+    lerp16(lerp16(lerp16(grad(P(AA),     x0, y0, z0),
+                         grad(P(BA),     x1, y0, z0), u),
+                  lerp16(grad(P(AB),     x0, y1, z0),
+                         grad(P(BB),     x1, y1, z0), u), v),
+           lerp16(lerp16(grad(P(AA + 1), x0, y0, z1),
+                         grad(P(BA + 1), x1, y0, z1), u),
+                  lerp16(grad(P(AB + 1), x0, y1, z1),
+                         grad(P(BB + 1), x1, y1, z1), u), v), w));
+}
+
+uint8_t DotStarFX::noise8(uint16_t x, uint16_t y, uint16_t z) {
+  return noise16((uint32_t)x << 8, (uint32_t)y << 8, (uint32_t)z << 8) >> 8;
+}
+
+/*!
+  @brief   2D value noise: random values at lattice points, smoothly
+           interpolated.  Cheaper and blockier than noise16().
+  @param   x,y  Coordinates, 16.16 fixed point.
+  @return  Noise value 0-65535.
+*/
+uint16_t DotStarFX::valueNoise16(uint32_t x, uint32_t y) {
+  uint8_t  X = x >> 16, Y = y >> 16;
+  uint32_t u = ease16(x & 0xFFFF) >> 1, v = ease16(y & 0xFFFF) >> 1;
+  uint8_t  A = P(X) + Y, B = P(X + 1) + Y;
+  // Lattice values as 8.8 so the 15-bit fractions below can't overflow
+  int32_t  a = P(A) << 8, b = P(B) << 8, c = P(A + 1) << 8, d = P(B + 1) << 8;
+  int32_t  ab = a + (((b - a) * (int32_t)u) >> 15);
+  int32_t  cd = c + (((d - c) * (int32_t)u) >> 15);
+  int32_t  n  = ab + (((cd - ab) * (int32_t)v) >> 15);
+  return n + (n >> 8);                 // 0-65280 -> 0-65535
+}
+
+uint8_t DotStarFX::valueNoise8(uint16_t x, uint16_t y) {
+  return valueNoise16((uint32_t)x << 8, (uint32_t)y << 8) >> 8;
+}
+
+/*!
+  @brief   Batch version of noise16() for a row of pixels: out[i] =
+           noise16(x + i * dx, y, z).  Because y and z are fixed along
+           the row, their fade and lattice hashing happen once, and the
+           eight corner gradients are reduced to 'a * x + b' once per
+           lattice cell, leaving only a few adds and lerps per pixel.
+  @param   out    Destination, 'count' values.
+  @param   count  Number of samples.
+  @param   x      Starting x, 16.16 fixed point.
+  @param   dx     Step in x per sample, 16.16 fixed point.
+  @param   y,z    Fixed y and z, 16.16 fixed point.
+*/
+void DotStarFX::noiseSpan16(uint16_t *out, uint16_t count, uint32_t x,
+  uint32_t dx, uint32_t y, uint32_t z) {
+  uint8_t  Y  = y >> 16, Z = z >> 16;
+  uint32_t fy = y & 0xFFFF, fz = z & 0xFFFF;
+  uint32_t v  = ease16(fy), w = ease16(fz);
+  int32_t  y0 = fy >> 4, z0 = fz >> 4, y1 = y0 - 4096, z1 = z0 - 4096;
+  int32_t  ca[8], cb[8];               // Per corner: grad = ca * x + cb
+  int      cell = -1;                  // Lattice x the corners are for
+
+  while (count--) {
+    uint8_t X = x >> 16;
+    if (X != cell) {                   // Entered a new cell, redo corners
+      cell = X;
+      uint8_t A  = P(X) + Y,  B  = P(X + 1) + Y;
+      uint8_t AA = P(A) + Z,  AB = P(A + 1) + Z;
+      uint8_t BA = P(B) + Z,  BB = P(B + 1) + Z;
+      const uint8_t h[8] = { P(AA), P(BA), P(AB), P(BB),
+                             P(AA + 1), P(BA + 1), P(AB + 1), P(BB + 1) };
+      for (uint8_t k = 0; k < 8; k++) {
+        int32_t yq = (k & 2) ? y1 : y0, zq = (k & 4) ? z1 : z0;
+        ca[k] = grad(h[k], 1, 0, 0);   // Coefficient of x: -1, 0 or 1
+        cb[k] = grad(h[k], 0, yq, zq); // Everything else is constant
+      }
+    }
+    uint32_t fx = x & 0xFFFF, u = ease16(fx);
+    int32_t  x0 = fx >> 4, x1 = x0 - 4096;
+    *out++ = to_u16(
+      lerp16(lerp16(lerp16(ca[0] * x0 + cb[0], ca[1] * x1 + cb[1], u),
+                    lerp16(ca[2] * x0 + cb[2], ca[3] * x1 + cb[3], u), v),
+             lerp16(lerp16(ca[4] * x0 + cb[4], ca[5] * x1 + cb[5], u),
+                    lerp16(ca[6] * x0 + cb[6], ca[7] * x1 + cb[7], u), v), w));
+    x += dx;
+  }
+}
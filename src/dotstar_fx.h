@@ -0,0 +1,120 @@
+/*------------------------------------------------------------------------
+  Fixed-point effect math for the Particle DotStar library: 16-bit sine
+  and cosine, beat (tempo) generators, and 8/16-bit value and gradient
+  noise for organic effects like fire, plasma and clouds.
+
+  Everything here is integer-only and table driven, so it's fast on
+  Cortex-M parts without an FPU.  It doesn't depend on the strip class
+  and also builds on a desktop compiler (see tools/bench-fx).
+
+  Coordinates for noise are fixed point: 8.8 for the 8-bit functions and
+  16.16 for the 16-bit ones, i.e. the integer part picks the lattice cell
+  and the fraction the position within it.  Moving one whole unit gives
+  a completely new value, so small steps (e.g. 0x2000 per pixel in 16.16)
+  give smooth gradients.
+  ------------------------------------------------------------------------*/
+
+#ifndef _DOTSTAR_FX_H_
+#define _DOTSTAR_FX_H_
+
+#if defined(PLATFORM_ID)
+#include "application.h"
+#else // Desktop build
+#include <stdint.h>
+#ifndef PROGMEM
+#define PROGMEM
+#define pgm_read_byte(addr) (*(const uint8_t *)(addr))
+#define pgm_read_word(addr) (*(const uint16_t *)(addr))
+#endif
+#endif
+
+/* A PROGMEM (flash mem) table containing a signed 16-bit sine wave, one
+   full cycle in 256 steps plus a copy of the first entry at the end so
+   interpolation needn't wrap.  Python snippet to regenerate:
+import math
+for x in range(257):
+    print("{:6},".format(int(round(math.sin(x/128.0*math.pi)*32767)))),
+    if x%10 == 9: print
+*/
+static const int16_t PROGMEM _DotStarSin16Table[257] = {
+       0,   804,  1608,  2410,  3212,  4011,  4808,  5602,  6393,  7179,
+    7962,  8739,  9512, 10278, 11039, 11793, 12539, 13279, 14010, 14732,
+   15446, 16151, 16846, 17530, 18204, 18868, 19519, 20159, 20787, 21403,
+   22005, 22594, 23170, 23731, 24279, 24811, 25329, 25832, 26319, 26790,
+   27245, 27683, 28105, 28510, 28898, 29268, 29621, 29956, 30273, 30571,
+   30852, 31113, 31356, 31580, 31785, 31971, 32137, 32285, 32412, 32521,
+   32609, 32678, 32728, 32757, 32767, 32757, 32728, 32678, 32609, 32521,
+   32412, 32285, 32137, 31971, 31785, 31580, 31356, 31113, 30852, 30571,
+   30273, 29956, 29621, 29268, 28898, 28510, 28105, 27683, 27245, 26790,
+   26319, 25832, 25329, 24811, 24279, 23731, 23170, 22594, 22005, 21403,
+   20787, 20159, 19519, 18868, 18204, 17530, 16846, 16151, 15446, 14732,
+   14010, 13279, 12539, 11793, 11039, 10278,  9512,  8739,  7962,  7179,
+    6393,  5602,  4808,  4011,  3212,  2410,  1608,   804,     0,  -804,
+   -1608, -2410, -3212, -4011, -4808, -5602, -6393, -7179, -7962, -8739,
+   -9512,-10278,-11039,-11793,-12539,-13279,-14010,-14732,-15446,-16151,
+  -16846,-17530,-18204,-18868,-19519,-20159,-20787,-21403,-22005,-22594,
+  -23170,-23731,-24279,-24811,-25329,-25832,-26319,-26790,-27245,-27683,
+  -28105,-28510,-28898,-29268,-29621,-29956,-30273,-30571,-30852,-31113,
+  -31356,-31580,-31785,-31971,-32137,-32285,-32412,-32521,-32609,-32678,
+  -32728,-32757,-32767,-32757,-32728,-32678,-32609,-32521,-32412,-32285,
+  -32137,-31971,-31785,-31580,-31356,-31113,-30852,-30571,-30273,-29956,
+  -29621,-29268,-28898,-28510,-28105,-27683,-27245,-26790,-26319,-25832,
+  -25329,-24811,-24279,-23731,-23170,-22594,-22005,-21403,-20787,-20159,
+  -19519,-18868,-18204,-17530,-16846,-16151,-15446,-14732,-14010,-13279,
+  -12539,-11793,-11039,-10278, -9512, -8739, -7962, -7179, -6393, -5602,
+   -4808, -4011, -3212, -2410, -1608,  -804,     0};
+
+class DotStarFX {
+
+ public:
+  /*!
+    @brief   A 16-bit integer sine wave function, the higher-resolution
+             sibling of Adafruit_DotStar::sine8().
+    @param   theta  Input angle, 0-65535 for one full circle; like sine8()
+                    it can be allowed to overflow/underflow freely.
+    @return  Sine result, -32767 to +32767.  Linearly interpolated between
+             256 table entries; error is within about 0.01%.
+  */
+  static int16_t sin16(uint16_t theta) {
+    uint8_t i = theta >> 8;
+    int16_t a = (int16_t)pgm_read_word(&_DotStarSin16Table[i]);
+    int16_t b = (int16_t)pgm_read_word(&_DotStarSin16Table[i + 1]);
+    return a + (((int32_t)(b - a) * (theta & 0xFF)) >> 8);
+  }
+  static int16_t cos16(uint16_t theta) {
+    return sin16(theta + 16384);
+  }
+  /*!
+    @brief   Sawtooth that ramps 0-65535 'bpm' times per minute.
+    @param   bpm  Beats per minute.
+    @param   ms   Current time, normally millis().
+    @return  Phase within the current beat, usable as a sin16() angle.
+  */
+  static uint16_t beat16(uint16_t bpm, uint32_t ms) {
+    // 65536/60000 ~= 280/256; overflow only discards whole beats
+    return (ms * bpm * 280) >> 8;
+  }
+  static uint8_t beat8(uint16_t bpm, uint32_t ms) {
+    return beat16(bpm, ms) >> 8;
+  }
+  static uint16_t
+    beatsin16(uint16_t bpm, uint16_t lo, uint16_t hi, uint32_t ms,
+              uint16_t phase = 0);          // Sine between lo and hi
+  static uint8_t
+    beatsin8(uint16_t bpm, uint8_t lo, uint8_t hi, uint32_t ms,
+             uint8_t phase = 0);
+
+  static uint16_t
+    noise16(uint32_t x, uint32_t y = 0,     // Gradient noise, 16.16 in
+            uint32_t z = 0),
+    valueNoise16(uint32_t x, uint32_t y = 0); // Value noise, 16.16 in
+  static uint8_t
+    noise8(uint16_t x, uint16_t y = 0,      // Gradient noise, 8.8 in
+           uint16_t z = 0),
+    valueNoise8(uint16_t x, uint16_t y = 0); // Value noise, 8.8 in
+  static void
+    noiseSpan16(uint16_t *out, uint16_t count, // Batch noise16() along x
+                uint32_t x, uint32_t dx, uint32_t y = 0, uint32_t z = 0);
+};
+
+#endif // _DOTSTAR_FX_H_
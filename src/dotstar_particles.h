@@ -0,0 +1,279 @@
+/*------------------------------------------------------------------------
+  Particle/sprite effect engine for the Particle DotStar library.
+
+  Comets, sparks, ripples and the like as a pool of up to MAX particles,
+  sized at compile time (no heap).  Positions and velocities are 16.16
+  fixed point, so particles move smoothly between pixels and are drawn
+  anti-aliased.  Each particle has a color, an optional lifetime over
+  which it fades out, and an optional tail trailing behind it.
+
+  render() sorts the particles, merges their extents into spans, and
+  builds each span once in a small buffer, blending every particle that
+  touches it (additive or max), then hands it to the strip in one
+  setPixels() call.  Spans lit last frame but empty now are cleared the
+  same way.  Pixels outside those spans are never read or written, so
+  the cost follows the number and size of particles, not strip length.
+
+    DotStarParticles<32> fx(strip);
+    fx.spawn(DOTSTAR_FIXED(0), DOTSTAR_FIXED(40), 0xFF8000, 0, 6); // Comet
+    ...
+    fx.update(elapsedMs);
+    fx.render();
+    strip.show();
+  ------------------------------------------------------------------------*/
+
+#ifndef _DOTSTAR_PARTICLES_H_
+#define _DOTSTAR_PARTICLES_H_
+
+#include "dotstar.h"
+
+// How overlapping particles combine (see setBlend()):
+#define DOTSTAR_BLEND_ADD 0 // Sum channels, clipping at 255
+#define DOTSTAR_BLEND_MAX 1 // Brightest channel wins
+
+// Convert a (constant) number of pixels to 16.16 fixed point.
+#define DOTSTAR_FIXED(x) ((int32_t)((x) * 65536L))
+
+// Pixels rendered per pass through the span buffer
+#define DOTSTAR_PARTICLE_CHUNK 32
+
+struct DotStarParticle {
+  int32_t  pos;                             // Pixels, 16.16
+  int32_t  vel;                             // Pixels per second, 16.16
+  uint32_t color;                           // Packed RGB at full life
+  uint16_t life;                            // ms left, counts down
+  uint16_t lifetime;                        // Total ms, 0 = never fades
+  uint8_t  tail;                            // Trail length in pixels
+};
+
+template <uint16_t MAX>
+class DotStarParticles {
+
+ public:
+  DotStarParticles(Adafruit_DotStar &s, uint8_t blend = DOTSTAR_BLEND_ADD) :
+   strip(s), numLive(0), numPrev(0), blendMode(blend) {
+    clear();
+  }
+
+  /*!
+    @brief   Start a new particle.
+    @param   pos       Position in pixels, 16.16 (see DOTSTAR_FIXED()).
+    @param   vel       Velocity in pixels per second, 16.16.  The tail
+                       trails opposite to the direction of travel.
+    @param   color     Packed RGB color.
+    @param   lifetime  ms to fade out over and then disappear; 0 = lives
+                       until it leaves the strip or is kill()ed.
+    @param   tail      Trail length in pixels, fading linearly, 0 = none.
+    @return  Particle slot (for get()/kill()), or -1 if the pool is full.
+  */
+  int16_t spawn(int32_t pos, int32_t vel, uint32_t color,
+                uint16_t lifetime = 0, uint8_t tail = 0) {
+    if (numLive >= MAX) return -1;
+    uint16_t slot = freeList[MAX - 1 - numLive];
+    DotStarParticle *p = &pool[slot];
+    p->pos      = pos;
+    p->vel      = vel;
+    p->color    = color;
+    p->life     = lifetime;
+    p->lifetime = lifetime;
+    p->tail     = tail;
+    live[numLive++] = slot;
+    return slot;
+  }
+
+  // Direct access to a particle, e.g. to steer it.  NULL if not in use.
+  DotStarParticle *get(int16_t slot) {
+    for (uint16_t i = 0; i < numLive; i++) {
+      if (live[i] == slot) return &pool[slot];
+    }
+    return NULL;
+  }
+
+  void kill(int16_t slot) {
+    for (uint16_t i = 0; i < numLive; i++) {
+      if (live[i] == slot) {
+        remove(i);
+        return;
+      }
+    }
+  }
+
+  // Remove all particles.  The next render() clears what they lit.
+  void clear(void) {
+    numLive = 0;
+    for (uint16_t i = 0; i < MAX; i++) freeList[i] = MAX - 1 - i;
+  }
+
+  void setBlend(uint8_t blend) {
+    blendMode = blend;
+  }
+
+  uint16_t active(void) const {
+    return numLive;
+  }
+
+  /*!
+    @brief   Advance all particles by 'ms' milliseconds: move them, age
+             them, and free those that expired or left the strip.
+  */
+  void update(uint32_t ms) {
+    int32_t end = (int32_t)strip.numPixels() << 16;
+    for (uint16_t i = numLive; i--; ) {
+      DotStarParticle *p = &pool[live[i]];
+      p->pos += (int32_t)(((int64_t)p->vel * ms) / 1000);
+      if (p->lifetime) {
+        if (p->life <= ms) {
+          remove(i);
+          continue;
+        }
+        p->life -= ms;
+      }
+      // Gone once the whole tail is past either end, heading away
+      int32_t margin = ((int32_t)p->tail + 1) << 16;
+      if (((p->vel >= 0) && (p->pos - margin >= end)) ||
+          ((p->vel <= 0) && (p->pos + margin < 0))) {
+        remove(i);
+      }
+    }
+  }
+
+  /*!
+    @brief   Draw all particles into the strip, clearing pixels they lit
+             on the previous render() and no longer cover.  Overlaps are
+             combined per the blend mode; particles draw over black.
+  */
+  void render(void) {
+    uint16_t n = 0, numPixels = strip.numPixels();
+
+    // Extents of live particles plus last frame's spans, sorted by start
+    for (uint16_t i = 0; i < numLive; i++) {
+      DotStarParticle *p = &pool[live[i]];
+      int32_t behind = ((int32_t)p->tail + 1) << 16;
+      int32_t lo = (p->vel >= 0) ? p->pos - behind : p->pos - 65536;
+      int32_t hi = (p->vel >= 0) ? p->pos + 65536  : p->pos + behind;
+      lo = (lo >> 16) + 1;               // Pixels with nonzero weight
+      hi = ((hi + 65535) >> 16);
+      if (lo < 0)         lo = 0;
+      if (hi > numPixels) hi = numPixels;
+      if (lo < hi) insert(n++, lo, hi, live[i]);
+    }
+    for (uint16_t i = 0; i < numPrev; i++) {
+      insert(n++, prevLo[i], prevHi[i], NO_PARTICLE);
+    }
+
+    // Merge into disjoint spans and build each one
+    numPrev = 0;
+    for (uint16_t a = 0; a < n; ) {
+      uint16_t lo = span[a].lo, hi = span[a].hi, b = a + 1;
+      while ((b < n) && (span[b].lo <= hi)) {
+        if (span[b].hi > hi) hi = span[b].hi;
+        b++;
+      }
+      draw_span(lo, hi, a, b);
+      uint16_t j;                        // Remember spans particles lit
+      for (j = a; (j < b) && (span[j].slot == NO_PARTICLE); j++);
+      if (j < b) {
+        prevLo[numPrev] = lo;
+        prevHi[numPrev] = hi;
+        numPrev++;
+      }
+      a = b;
+    }
+  }
+
+ private:
+
+  enum { NO_PARTICLE = 0xFFFF };
+
+  struct Extent {
+    uint16_t lo, hi;                        // Pixels [lo, hi)
+    uint16_t slot;                          // Particle, or NO_PARTICLE
+  };
+
+  Adafruit_DotStar
+   &strip;
+  DotStarParticle
+    pool[MAX];
+  uint16_t
+    live[MAX],                              // Slots in use
+    freeList[MAX],                          // Slots free (stack)
+    numLive,
+    prevLo[MAX],                            // Spans lit last render()
+    prevHi[MAX],
+    numPrev;
+  Extent
+    span[MAX * 2];                          // Scratch for render()
+  uint8_t
+    blendMode;
+
+  void remove(uint16_t i) {
+    freeList[MAX - numLive] = live[i];
+    live[i] = live[--numLive];
+  }
+
+  // Insertion sort by start; particles barely move between frames, so
+  // the list is nearly sorted already and this is close to linear.
+  void insert(uint16_t n, uint16_t lo, uint16_t hi, uint16_t slot) {
+    while (n && (span[n - 1].lo > lo)) {
+      span[n] = span[n - 1];
+      n--;
+    }
+    span[n].lo   = lo;
+    span[n].hi   = hi;
+    span[n].slot = slot;
+  }
+
+  // Build pixels [lo, hi) from extents span[a..b), a chunk at a time
+  void draw_span(uint16_t lo, uint16_t hi, uint16_t a, uint16_t b) {
+    uint16_t acc[DOTSTAR_PARTICLE_CHUNK * 3];
+    uint8_t  rgb[DOTSTAR_PARTICLE_CHUNK * 3];
+    for (uint16_t c0 = lo; c0 < hi; c0 += DOTSTAR_PARTICLE_CHUNK) {
+      uint16_t c1 = (hi - c0 > DOTSTAR_PARTICLE_CHUNK) ?
+                    c0 + DOTSTAR_PARTICLE_CHUNK : hi;
+      memset(acc, 0, sizeof(acc));
+      for (uint16_t j = a; j < b; j++) {
+        if ((span[j].slot == NO_PARTICLE) ||
+            (span[j].lo >= c1) || (span[j].hi <= c0)) continue;
+        draw_particle(&pool[span[j].slot], acc, c0,
+                      (span[j].lo > c0) ? span[j].lo : c0,
+                      (span[j].hi < c1) ? span[j].hi : c1);
+      }
+      for (uint16_t i = 0; i < (c1 - c0) * 3; i++) {
+        rgb[i] = (acc[i] > 255) ? 255 : acc[i];
+      }
+      strip.setPixels(c0, c1 - c0, rgb);
+    }
+  }
+
+  // Blend one particle's pixels [from, to) into the chunk starting at c0.
+  // Weight is a tent filter around the head (anti-aliasing) and a linear
+  // ramp down over the tail behind it.
+  void draw_particle(const DotStarParticle *p, uint16_t *acc, uint16_t c0,
+                     uint16_t from, uint16_t to) {
+    uint16_t level = p->lifetime ?
+                     (uint32_t)p->life * 256 / p->lifetime : 256;
+    uint32_t step  = 65536 / ((uint32_t)p->tail + 1);
+    uint8_t  r = p->color >> 16, g = p->color >> 8, b = p->color;
+    for (uint16_t i = from; i < to; i++) {
+      int32_t  d    = ((int32_t)i << 16) - p->pos;
+      boolean  back = (p->vel >= 0) ? (d < 0) : (d > 0);
+      uint32_t dist = ((d < 0) ? -d : d) >> 8;  // 8.8 pixels
+      uint32_t w    = back ? (dist * step) >> 16 : dist;
+      if (w >= 256) continue;
+      w = ((256 - w) * level) >> 8;             // 0-256
+      uint16_t *c = &acc[(i - c0) * 3];
+      uint16_t cr = (r * w) >> 8, cg = (g * w) >> 8, cb = (b * w) >> 8;
+      if (blendMode == DOTSTAR_BLEND_MAX) {
+        if (cr > c[0]) c[0] = cr;
+        if (cg > c[1]) c[1] = cg;
+        if (cb > c[2]) c[2] = cb;
+      } else {
+        c[0] += cr;
+        c[1] += cg;
+        c[2] += cb;
+      }
+    }
+  }
+};
+
+#endif // _DOTSTAR_PARTICLES_H_
@@ -0,0 +1,272 @@
+/*------------------------------------------------------------------------
+  Persistence-of-vision column streaming for the Particle DotStar library.
+  See dotstar_pov.h.
+  ------------------------------------------------------------------------*/
+
+#include "dotstar_pov.h"
+
+#ifndef DOTSTAR_LINUX
+
+#define NO_SYNC_PIN 0xFFFF
+
+DotStarPOV *DotStarPOV::active = NULL;
+
+DotStarPOV::DotStarPOV(Adafruit_DotStar &s) :
+ strip(s), encoded(NULL), frameLen(0), numColumns(0), syncPin(NO_SYNC_PIN),
+ autoRate(false), running(false), busy(false), anchored(false), column(0),
+ period(1000), nextDue(0), lastSync(0), revPeriod(0), sent(0), missed(0)
+#if PLATFORM_THREADING
+ , thread(NULL), threadRun(false)
+#endif
+{
+}
+
+DotStarPOV::~DotStarPOV(void) {
+#if PLATFORM_THREADING
+  stopThread();                        // No more service() calls
+#endif
+  detachSync();                        // No more sync_isr() calls
+  stop();                              // Waits for the last column
+  if (active == this) active = NULL;
+  if (encoded) free(encoded);
+}
+
+/*!
+  @brief   Encode every column of an image into its own ready-to-send
+           APA102 frame, using the strip's current brightness.  This
+           overwrites the strip's pixel buffer (it's cleared afterward).
+           Call again after changing brightness.
+  @param   image    Column-major R,G,B data, 'height' pixels per column.
+                    May live in flash; it isn't needed after this call.
+  @param   columns  Number of columns in the image.
+  @param   height   Pixels per column.  Shorter than the strip leaves the
+                    remaining pixels off; longer is cropped.
+  @return  false if memory for the encoded columns couldn't be allocated
+           (needs columns * strip.encodedLength() bytes).
+*/
+boolean DotStarPOV::begin(const uint8_t *image, uint16_t columns,
+  uint16_t height) {
+  stop();
+  if (encoded) free(encoded);
+  frameLen   = strip.encodedLength();
+  numColumns = 0;
+  if (!columns ||
+      !(encoded = (uint8_t *)malloc((uint32_t)columns * frameLen))) {
+    encoded = NULL;
+    return false;
+  }
+  for (uint16_t c = 0; c < columns; c++) {
+    strip.clear();
+    strip.setPixels(0, height, &image[(uint32_t)c * height * 3]);
+    strip.encode(&encoded[(uint32_t)c * frameLen]);
+  }
+  strip.clear();
+  numColumns = columns;
+  column     = 0;
+  return true;
+}
+
+void DotStarPOV::setColumnRate(uint32_t hz) {
+  if (hz) period = (hz < 1000000UL) ? 1000000UL / hz : 1;
+}
+
+uint32_t DotStarPOV::columnRate(void) const {
+  return period ? 1000000UL / period : 0;
+}
+
+void DotStarPOV::start(void) {
+  if (!encoded) return;
+  active   = this;
+  busy     = false;
+  anchored = false;
+  column   = 0;
+  nextDue  = micros();
+  running  = true;
+}
+
+// Stop sending columns.  Returns once any column transfer in progress
+// has finished, so the encoded columns may then be freed or replaced.
+void DotStarPOV::stop(void) {
+  running = false;
+  while (busy);                        // transfer_done() clears it
+}
+
+// DMA completion (interrupt context): the wire is free for the next one
+void DotStarPOV::transfer_done(void) {
+  if (active) active->busy = false;
+}
+
+void DotStarPOV::send_column(void) {
+  if (busy) {                          // Previous column still going out
+    missed++;
+    if (++column >= numColumns) column = 0; // Keep image in phase
+    return;
+  }
+  busy   = true;
+  if (!running) {                      // stop() got in first; it may be
+    busy = false;                      //  about to free 'encoded'
+    return;
+  }
+  active = this;                       // transfer_done() clears our 'busy'
+  const uint8_t *frame = &encoded[(uint32_t)column * frameLen];
+  if (++column >= numColumns) column = 0;
+  sent++;
+  strip.showEncoded(frame, frameLen, transfer_done);
+}
+
+/*!
+  @brief   Send the next column.  Meant to be called from a software
+           timer or thread at the column rate (not from an interrupt;
+           see dotstar_pov.h); it only starts a transfer and returns.
+           Each call is checked against the column period: one that
+           comes more than half a column late counts as missed (and
+           columns are skipped to stay in phase), and one that comes
+           that early, e.g. a timer catching up, is ignored.
+*/
+void DotStarPOV::tick(void) {
+  if (!running) return;
+  uint32_t now = micros();
+  if (!anchored) {                     // First tick since start()/sync()
+    nextDue  = now;
+    anchored = true;
+  }
+  int32_t late = (int32_t)(now - nextDue), half = period / 2;
+  if (late < -half) return;            // Early: not this column's turn
+  if (late >  half) {                  // Late by one or more columns
+    uint32_t behind = ((uint32_t)late + half) / period;
+    missed  += behind;
+    column   = (column + behind) % numColumns;
+    nextDue += behind * period;
+  }
+  nextDue += period;
+  send_column();
+}
+
+/*!
+  @brief   Polled alternative to a timer interrupt: call as often as
+           possible from loop().  Sends a column whenever one is due; if
+           loop() fell behind by whole columns, those are counted as
+           missed and skipped so the image stays in phase.
+*/
+void DotStarPOV::service(void) {
+  if (!running) return;
+  uint32_t now  = micros();
+  int32_t  late = (int32_t)(now - nextDue);
+  if (late < 0) return;                // Not due yet
+  uint32_t behind = (uint32_t)late / period;
+  if (behind) {
+    missed  += behind;
+    column   = (column + behind) % numColumns;
+    nextDue += behind * period;
+  }
+  nextDue += period;
+  send_column();
+}
+
+/*!
+  @brief   Restart the image at column 0, e.g. from a once-per-revolution
+           sensor.  With autoRate (see attachSync()) the column rate is
+           also set so the whole image spans one measured revolution.
+           service() and the thread use the new rate right away; with
+           tick(), check columnRate() and reprogram the timer.
+*/
+void DotStarPOV::sync(void) {
+  uint32_t now = micros();
+  if (lastSync) {
+    revPeriod = now - lastSync;
+    if (autoRate && numColumns && (revPeriod >= numColumns)) {
+      period = revPeriod / numColumns;
+    }
+  }
+  lastSync = now;
+  column   = 0;
+  nextDue  = now;
+  anchored = false;                    // tick() times from its next call
+}
+
+void DotStarPOV::sync_isr(void) {
+  if (active) active->sync();
+}
+
+void DotStarPOV::attachSync(uint16_t pin, InterruptMode edge,
+  boolean rate) {
+  detachSync();
+  active   = this;
+  syncPin  = pin;
+  autoRate = rate;
+  lastSync = 0;
+  pinMode(pin, INPUT_PULLUP);          // Typical open-drain Hall sensor
+  attachInterrupt(pin, sync_isr, edge);
+}
+
+void DotStarPOV::detachSync(void) {
+  if (syncPin == NO_SYNC_PIN) return;
+  detachInterrupt(syncPin);
+  syncPin = NO_SYNC_PIN;
+}
+
+uint32_t DotStarPOV::columnsSent(void) const {
+  return sent;
+}
+
+uint32_t DotStarPOV::missedDeadlines(void) const {
+  return missed;
+}
+
+uint32_t DotStarPOV::revolutionPeriod(void) const {
+  return revPeriod;
+}
+
+#if PLATFORM_THREADING
+/*!
+  @brief   Send columns from a thread of our own instead of service() or
+           tick(), so their timing doesn't depend on loop().  The thread
+           follows start(), stop(), sync() and autoRate like service().
+  @param   priority  RTOS priority; the default is one above loop().
+                     See dotstar_pov.h about what spinning at a high
+                     priority costs other threads.
+  @return  false if the thread couldn't be created.
+*/
+boolean DotStarPOV::startThread(uint8_t priority) {
+  if (thread) return true;
+  threadRun = true;
+  if (os_thread_create(&thread, "dotstar_pov", (os_thread_prio_t)priority,
+      thread_loop, this, DOTSTAR_POV_STACK)) {
+    thread    = NULL;
+    threadRun = false;
+    return false;
+  }
+  return true;
+}
+
+// Ends the thread and waits for it to exit; columns stop until
+// startThread() or calls to service() or tick().
+void DotStarPOV::stopThread(void) {
+  if (!thread) return;
+  threadRun = false;
+  os_thread_join(thread);
+  os_thread_cleanup(thread);
+  thread = NULL;
+}
+
+// Sleep while the next column is far off (the RTOS tick is 1 ms), then
+// spin on micros() for the last DOTSTAR_POV_SPIN_US and send it.
+os_thread_return_t DotStarPOV::thread_loop(void *arg) {
+  DotStarPOV *pov = (DotStarPOV *)arg;
+  while (pov->threadRun) {
+    if (!pov->running) {
+      delay(1);                        // Idle until start()
+      continue;
+    }
+    int32_t wait = (int32_t)(pov->nextDue - micros());
+    if (wait > DOTSTAR_POV_SPIN_US + 1000) {
+      delay(1);                        // 1 ms at a time, in case sync()
+    } else {                           //  moves the deadline earlier
+      pov->service();                  // Returns at once if not due
+    }
+  }
+  os_thread_exit(NULL);
+}
+#endif // PLATFORM_THREADING
+
+#endif // !DOTSTAR_LINUX
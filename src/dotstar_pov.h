@@ -0,0 +1,147 @@
+/*------------------------------------------------------------------------
+  Persistence-of-vision column streaming for the Particle DotStar library.
+
+  An image is given as a table of columns, each one strip-length of
+  R,G,B pixels (column-major: all of column 0, then column 1...).  Every
+  column is encoded up front into a complete APA102 frame, so sending a
+  column is a single bulk transfer with no per-pixel work.
+
+  Columns can be sent three ways, each timed against micros() deadlines:
+
+  - startThread() runs a dedicated, high-priority thread owned by the
+    DotStarPOV that sleeps until shortly before each column is due,
+    then spins on micros() and sends it.  Timing doesn't depend on
+    loop() at all, so this is the one to use for a real display.
+  - service(), called from loop() as often as possible.  Any time
+    spent elsewhere in loop() (or the system between loops) delays
+    columns.
+  - tick(), called by your own timer at the column rate.  Device OS
+    doesn't support starting an SPI transfer from interrupt context on
+    any platform this library targets (SPI calls take a lock), so it
+    must not be called from a hardware timer ISR; use a software Timer
+    (1 ms resolution, so up to 1000 columns per second) or a thread.
+
+  On hardware SPI the transfer runs in the background by DMA.  A column
+  that can't go out on time counts as a missed deadline: the previous
+  one is still on the wire, or its time slot passed (a whole column
+  late for service() and the thread, over half a column for tick()).
+  Columns missed that way are skipped to keep the image in phase.
+
+  The POV thread sleeps in whole milliseconds and only while the next
+  column is over a millisecond more than DOTSTAR_POV_SPIN_US away, so
+  above roughly 400 columns per second it never sleeps.  Threads of
+  lower priority, loop()'s included, then only get the CPU while it's
+  stopped.
+  Pass a lower priority to startThread() to trade some column timing
+  for them.
+
+  An optional sync input (e.g. a Hall sensor, once per revolution)
+  restarts the image at column 0.  With autoRate it also derives the
+  column rate from the measured revolution period.  service() and the
+  thread pick up the new rate by themselves; with tick(), poll
+  columnRate() and reprogram your timer when it changes.
+
+  Not available on Linux (no pin interrupts or background SPI there).
+  ------------------------------------------------------------------------*/
+
+#ifndef _DOTSTAR_POV_H_
+#define _DOTSTAR_POV_H_
+
+#include "dotstar.h"
+
+#ifndef DOTSTAR_LINUX
+
+// Once the next column is closer than this (us), the POV thread stops
+// sleeping and spins on micros().  Covers one RTOS tick of oversleep.
+#ifndef DOTSTAR_POV_SPIN_US
+#define DOTSTAR_POV_SPIN_US 1500
+#endif
+
+#if PLATFORM_THREADING
+// Default priority of the startThread() thread, above loop()'s
+#ifndef DOTSTAR_POV_PRIORITY
+#define DOTSTAR_POV_PRIORITY (OS_THREAD_PRIORITY_DEFAULT + 1)
+#endif
+#ifndef DOTSTAR_POV_STACK
+#define DOTSTAR_POV_STACK OS_THREAD_STACK_SIZE_DEFAULT
+#endif
+#endif // PLATFORM_THREADING
+
+class DotStarPOV {
+
+ public:
+  DotStarPOV(Adafruit_DotStar &strip);
+ ~DotStarPOV(void);
+  boolean
+    begin(const uint8_t *image,             // Pre-encode column table
+          uint16_t columns, uint16_t height);
+  void
+    setColumnRate(uint32_t hz),             // Columns per second
+    attachSync(uint16_t pin,                // Re-phase on sensor edge
+               InterruptMode edge = FALLING,
+               boolean autoRate = true),
+    detachSync(void),
+    start(void),
+    stop(void),
+    tick(void),                             // Send next column (not ISR)
+    service(void),                          // Send if due; call from loop
+    sync(void);                             // Re-phase to column 0 (ISR)
+  uint32_t
+    columnRate(void) const,                 // Current columns per second
+    columnsSent(void) const,
+    missedDeadlines(void) const,            // Columns not sent on time
+    revolutionPeriod(void) const;           // us between sync pulses
+#if PLATFORM_THREADING
+  boolean
+    startThread(uint8_t priority =          // Send from own thread
+                DOTSTAR_POV_PRIORITY);
+  void
+    stopThread(void);
+#endif
+
+ private:
+
+  Adafruit_DotStar
+   &strip;
+  uint8_t
+   *encoded;                                // numColumns encoded frames
+  uint32_t
+    frameLen;                               // Bytes per encoded column
+  uint16_t
+    numColumns,
+    syncPin;
+  boolean
+    autoRate;                               // Derive rate from sync
+  volatile boolean
+    running,
+    busy,                                   // Column still on the wire
+    anchored;                               // tick() has set nextDue
+  volatile uint16_t
+    column;                                 // Next column to send
+  volatile uint32_t
+    period,                                 // us per column
+    nextDue,                                // micros() next column is due
+    lastSync,                               // micros() of last sync pulse
+    revPeriod,                              // us per revolution
+    sent,
+    missed;
+  static DotStarPOV
+   *active;                                 // Target of ISR callbacks
+  static void
+    transfer_done(void),
+    sync_isr(void);
+  void
+    send_column(void);
+#if PLATFORM_THREADING
+  os_thread_t
+    thread;                                 // startThread(), else NULL
+  volatile boolean
+    threadRun;                              // Cleared to end the thread
+  static os_thread_return_t
+    thread_loop(void *pov);
+#endif
+};
+
+#endif // !DOTSTAR_LINUX
+
+#endif // _DOTSTAR_POV_H_
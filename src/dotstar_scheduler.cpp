@@ -0,0 +1,154 @@
+/*------------------------------------------------------------------------
+  Frame scheduler for the Particle DotStar library.
+  See dotstar_scheduler.h.
+  ------------------------------------------------------------------------*/
+
+#include "dotstar_scheduler.h"
+#include "dotstar_compat.h"
+
+// Exponentially weighted moving average, 1/8 weight to the new sample
+#define AVERAGE(avg, sample) \
+  ((avg) = (int32_t)(avg) + (((int32_t)(sample) - (int32_t)(avg)) >> 3))
+
+DotStarScheduler::DotStarScheduler(Adafruit_DotStar &s, uint16_t fps) :
+ strip(s), renderFunc(NULL), targetPeriod(0), maxPeriod(1000000UL),
+ period(0), nextDue(0), lastStart(0), carryUs(0), mode(DOTSTAR_SCHED_ADAPT) {
+  resetStats();
+  setTargetFPS(fps);
+}
+
+/*!
+  @brief   Set the function that draws each frame and start the clock;
+           the first frame is due right away.
+  @param   render  Called once per frame, before strip.show(), with the
+                   milliseconds since the previous frame started.  Any
+                   fraction of a millisecond is carried over to the next
+                   frame, so these add up to real time exactly.
+*/
+void DotStarScheduler::begin(void (*render)(uint32_t ms)) {
+  renderFunc = render;
+  lastStart  = nextDue = micros();
+  carryUs    = 0;
+}
+
+void DotStarScheduler::setTargetFPS(uint16_t fps) {
+  if (!fps) return;
+  targetPeriod = 1000000UL / fps;
+  if (maxPeriod < targetPeriod) maxPeriod = targetPeriod;
+  period       = targetPeriod;         // Adapts down again if need be
+  counters.fps = currentFPS();
+}
+
+// With DOTSTAR_SCHED_ADAPT, the rate is never lowered below this
+// (default 1); frames that still don't fit are counted as overruns.
+void DotStarScheduler::setMinFPS(uint16_t fps) {
+  if (!fps) fps = 1;
+  maxPeriod = 1000000UL / fps;
+  if (maxPeriod < targetPeriod) maxPeriod = targetPeriod;
+  if (period > maxPeriod)       period    = maxPeriod;
+  counters.fps = currentFPS();
+}
+
+void DotStarScheduler::setMode(uint8_t m) {
+  mode         = m;
+  period       = targetPeriod;
+  counters.fps = currentFPS();
+}
+
+void DotStarScheduler::resetStats(void) {
+  memset(&counters, 0, sizeof(counters));
+  counters.fps = currentFPS();
+}
+
+uint16_t DotStarScheduler::targetFPS(void) const {
+  return targetPeriod ? (1000000UL + targetPeriod / 2) / targetPeriod : 0;
+}
+
+uint16_t DotStarScheduler::currentFPS(void) const {
+  return period ? (1000000UL + period / 2) / period : 0;
+}
+
+const DotStarSchedulerStats &DotStarScheduler::stats(void) const {
+  return counters;
+}
+
+// Sleep most of the way (delay() lets the system run meanwhile), then
+// spin on micros() for the last millisecond or so.
+void DotStarScheduler::wait_until(uint32_t when) {
+  int32_t left;
+  while ((left = (int32_t)(when - micros())) > 0) {
+    if (left > 2000) delay((left - 1000) / 1000);
+  }
+}
+
+/*!
+  @brief   Call from loop().  Waits until the next frame is due, renders
+           it, shows it, and works out when the one after is due.
+  @param   wait  If false, return at once when the frame isn't due yet
+                 rather than sleeping, so loop() can do other work.
+  @return  true if a frame was rendered and shown.
+*/
+boolean DotStarScheduler::run(boolean wait) {
+  if (!renderFunc) return false;
+
+  uint32_t start = micros(), idle = 0;
+  if ((int32_t)(nextDue - start) > 0) {
+    if (!wait) return false;
+    wait_until(nextDue);
+    idle  = nextDue - start;
+    start = micros();
+  }
+
+  uint32_t us = start - lastStart + carryUs;
+  lastStart   = start;
+  carryUs     = us % 1000;
+  renderFunc(us / 1000);
+  uint32_t shown = micros();
+  strip.show();
+  uint32_t end = micros();
+
+  if (counters.frames++) {
+    AVERAGE(counters.renderUs, shown - start);
+    AVERAGE(counters.showUs,   end - shown);
+    AVERAGE(counters.idleUs,   idle);
+  } else {                             // First frame seeds the averages
+    counters.renderUs = shown - start;
+    counters.showUs   = end - shown;
+    counters.idleUs   = idle;
+  }
+
+  nextDue += period;
+  if ((int32_t)(end - nextDue) >= 0) { // Already late for the next one
+    counters.overruns++;
+    if (mode == DOTSTAR_SCHED_SKIP) {  // Stay on the target rate's grid
+      uint32_t missed = (end - nextDue) / period + 1;
+      counters.skipped += missed;
+      nextDue          += missed * period;
+    } else {
+      nextDue = end;                   // Don't burst to catch up
+    }
+  }
+  if (mode == DOTSTAR_SCHED_ADAPT) adapt();
+  return true;
+}
+
+// Pick the period from the average frame cost plus 1/8 headroom: slow
+// down as soon as frames don't fit, speed back up toward the target in
+// small steps once they fit with room to spare.
+void DotStarScheduler::adapt(void) {
+  uint32_t cost = counters.renderUs + counters.showUs;
+  uint32_t want = cost + cost / 8;
+  if (want < targetPeriod) want = targetPeriod;
+  if (want > maxPeriod)    want = maxPeriod;
+  if (want > period) {
+    period = want;
+  } else if ((period > want) &&
+             ((want == targetPeriod) || (want + want / 8 < period))) {
+    uint32_t p = period - period / 16;
+    period = (p > want) ? p : want;
+  } else {
+    return;
+  }
+  counters.rateChanges++;
+  counters.fps = currentFPS();
+}
@@ -0,0 +1,88 @@
+/*------------------------------------------------------------------------
+  Frame scheduler for the Particle DotStar library.
+
+  Pacing frames with a fixed delay() makes the real frame rate depend on
+  how long rendering and show() take, so long strips quietly fall short
+  of the intended rate and animations slow down with them.  Instead,
+  give the scheduler a target rate and a render function:
+
+    void render(uint32_t ms) {             // ms since previous frame
+      fx.update(ms);
+      fx.render();
+    }
+    DotStarScheduler sched(strip, 60);
+    sched.begin(render);
+    ...
+    void loop() { sched.run(); }
+
+  run() sleeps only until the next frame is due, then calls render()
+  with the time actually elapsed (so motion keeps real-time speed at any
+  frame rate) and calls strip.show().  Render and show() times are
+  measured every frame and averaged.  When the frame budget is exceeded,
+  the scheduler either lowers its output rate to what the strip can
+  sustain, raising it again once there's room (DOTSTAR_SCHED_ADAPT), or
+  keeps the target rate and skips the slots it missed
+  (DOTSTAR_SCHED_SKIP).  stats() reports what it did.
+  ------------------------------------------------------------------------*/
+
+#ifndef _DOTSTAR_SCHEDULER_H_
+#define _DOTSTAR_SCHEDULER_H_
+
+#include "dotstar.h"
+
+// What to do when frames take longer than the period (see setMode()):
+#define DOTSTAR_SCHED_ADAPT 0 // Lower the frame rate to fit (default)
+#define DOTSTAR_SCHED_SKIP  1 // Keep the rate, drop the missed slots
+
+struct DotStarSchedulerStats {
+  uint32_t frames;                          // Frames rendered and shown
+  uint32_t skipped;                         // Frame slots dropped
+  uint32_t overruns;                        // Frames ending past next slot
+  uint32_t rateChanges;                     // Adaptive rate adjustments
+  uint32_t renderUs;                        // Average render time, us
+  uint32_t showUs;                          // Average show() time, us
+  uint32_t idleUs;                          // Average time slept, us
+  uint16_t fps;                             // Current output rate
+};
+
+class DotStarScheduler {
+
+ public:
+  DotStarScheduler(Adafruit_DotStar &strip, uint16_t fps = 60);
+  void
+    begin(void (*render)(uint32_t ms)),     // Set render func, start clock
+    setTargetFPS(uint16_t fps),             // Rate to aim for
+    setMinFPS(uint16_t fps),                // Lowest adaptive rate
+    setMode(uint8_t mode),                  // DOTSTAR_SCHED_ADAPT or _SKIP
+    resetStats(void);
+  boolean
+    run(boolean wait = true);               // Wait for, render, show frame
+  uint16_t
+    targetFPS(void) const,
+    currentFPS(void) const;                 // Rate after adaptation
+  const DotStarSchedulerStats
+   &stats(void) const;
+
+ private:
+
+  Adafruit_DotStar
+   &strip;
+  void
+    (*renderFunc)(uint32_t ms);
+  DotStarSchedulerStats
+    counters;
+  uint32_t
+    targetPeriod,                           // us per frame at target rate
+    maxPeriod,                              // us per frame at minimum rate
+    period,                                 // us per frame currently
+    nextDue,                                // micros() next frame is due
+    lastStart,                              // micros() last frame started
+    carryUs;                                // Sub-ms time not yet passed on
+  uint8_t
+    mode;
+  void
+    wait_until(uint32_t when),              // Sleep, then spin to 'when'
+    adapt(void);                            // Re-pick period from costs
+};
+
+#endif // _DOTSTAR_SCHEDULER_H_
@@ -0,0 +1,102 @@
+/*------------------------------------------------------------------------
+  bench-fx: desktop throughput benchmark for the fixed-point effect math
+  in src/dotstar_fx.cpp, reported in pixels (samples) per second.
+
+  Runs on the host, not the device.  Build and run with:
+
+    g++ -O2 -Isrc -o bench-fx tools/bench-fx/bench-fx.cpp src/dotstar_fx.cpp
+    ./bench-fx [pixels-per-row]
+
+  Absolute numbers are for the host CPU; use them to compare functions
+  and spot regressions, not to predict Cortex-M frame rates.  A float
+  reference (per-pixel sinf()) is included as a baseline.
+  ------------------------------------------------------------------------*/
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "dotstar_fx.h"
+
+#define BENCH_SECONDS 0.5
+
+static double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static volatile uint32_t sink; // Keeps results from being optimized out
+
+// Run 'row' over successive rows of 'pixels' samples for BENCH_SECONDS
+// and print the resulting samples per second.
+static void bench(const char *name, int pixels,
+  uint32_t (*row)(int pixels, uint32_t frame)) {
+  uint32_t frames = 0, sum = 0;
+  double   start  = now(), elapsed;
+  do {
+    for (int i = 0; i < 16; i++) sum += row(pixels, frames++);
+    elapsed = now() - start;
+  } while (elapsed < BENCH_SECONDS);
+  sink = sum;
+  printf("%-28s %10.2f Mpixels/s\n", name,
+    (double)frames * pixels / elapsed / 1e6);
+}
+
+static uint16_t buf[65536];
+
+static uint32_t rowSin16(int pixels, uint32_t frame) {
+  uint32_t sum = 0;
+  for (int i = 0; i < pixels; i++) sum += DotStarFX::sin16(frame * 256 + i * 97);
+  return sum;
+}
+
+static uint32_t rowSinf(int pixels, uint32_t frame) {
+  uint32_t sum = 0;
+  for (int i = 0; i < pixels; i++)
+    sum += (int16_t)(sinf((frame * 256 + i * 97) * (float)(M_PI / 32768)) * 32767);
+  return sum;
+}
+
+static uint32_t rowValueNoise16(int pixels, uint32_t frame) {
+  uint32_t sum = 0;
+  for (int i = 0; i < pixels; i++)
+    sum += DotStarFX::valueNoise16(i * 0x2000, frame * 0x800);
+  return sum;
+}
+
+static uint32_t rowNoise8(int pixels, uint32_t frame) {
+  uint32_t sum = 0;
+  for (int i = 0; i < pixels; i++)
+    sum += DotStarFX::noise8(i * 0x20, 0x1234, frame * 8);
+  return sum;
+}
+
+static uint32_t rowNoise16(int pixels, uint32_t frame) {
+  uint32_t sum = 0;
+  for (int i = 0; i < pixels; i++)
+    sum += DotStarFX::noise16(i * 0x2000, 0x123456, frame * 0x800);
+  return sum;
+}
+
+static uint32_t rowNoiseSpan16(int pixels, uint32_t frame) {
+  DotStarFX::noiseSpan16(buf, pixels, 0, 0x2000, 0x123456, frame * 0x800);
+  return buf[pixels - 1];
+}
+
+int main(int argc, char *argv[]) {
+  int pixels = (argc > 1) ? atoi(argv[1]) : 300;
+  if ((pixels < 1) || (pixels > 65535)) {
+    fprintf(stderr, "usage: bench-fx [pixels-per-row (1-65535)]\n");
+    return 1;
+  }
+  printf("%d pixels per row\n", pixels);
+  bench("sinf() (float reference)", pixels, rowSinf);
+  bench("sin16()",                  pixels, rowSin16);
+  bench("valueNoise16()",           pixels, rowValueNoise16);
+  bench("noise8()",                 pixels, rowNoise8);
+  bench("noise16()",                pixels, rowNoise16);
+  bench("noiseSpan16()",            pixels, rowNoiseSpan16);
+  return 0;
+}
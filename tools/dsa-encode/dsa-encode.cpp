@@ -0,0 +1,173 @@
+/*------------------------------------------------------------------------
+  dsa-encode: convert raw RGB frames into a compact DotStar animation
+  (see src/dotstar_anim_format.h) for DotStarAnimPlayer.
+
+  Runs on the host, not the device.  Build with any C++ compiler:
+
+    g++ -O2 -o dsa-encode tools/dsa-encode/dsa-encode.cpp
+
+  Input is a headerless file of back-to-back frames, each 'pixels' * 3
+  bytes of R,G,B (e.g. from ffmpeg -pix_fmt rgb24 -f rawvideo, or a
+  script).  Usage:
+
+    dsa-encode -n pixels [-d ms] [-k keyint] input.rgb output.dsa
+
+    -n  Pixels per frame (required)
+    -d  Duration of each frame in milliseconds (default 20)
+    -k  Emit a keyframe every 'keyint' frames (default 0, first only)
+  ------------------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "../../src/dotstar_anim_format.h"
+
+typedef std::vector<uint8_t> Bytes;
+
+static void put16(Bytes &out, uint16_t v) {
+  out.push_back(v & 0xFF);
+  out.push_back(v >> 8);
+}
+
+// Op byte with the count packed in when it fits, else a uint16 follows.
+static void putOp(Bytes &out, uint8_t op, uint16_t count) {
+  if (count <= DSA_COUNT_MASK) {
+    out.push_back(op | count);
+  } else {
+    out.push_back(op);
+    put16(out, count);
+  }
+}
+
+static bool samePixel(const uint8_t *a, const uint8_t *b) {
+  return (a[0] == b[0]) && (a[1] == b[1]) && (a[2] == b[2]);
+}
+
+// Number of pixels from 'i' that repeat pixel 'i', capped at 'end'.
+static int runLength(const uint8_t *f, int i, int end) {
+  int n = 1;
+  while ((i + n < end) && (n < 0xFFFF) && samePixel(&f[(i + n) * 3], &f[i * 3]))
+    n++;
+  return n;
+}
+
+// Encode one frame as ops.  'prev' is NULL for a keyframe, in which case
+// no SKIP ops are emitted and every pixel is written.
+static void encodeFrame(Bytes &out, const uint8_t *cur, const uint8_t *prev,
+  int pixels, uint16_t duration) {
+  out.push_back(prev ? 0 : DSA_FRAME_KEY);
+  put16(out, duration);
+
+  int i = 0;
+  while (i < pixels) {
+    if (prev && samePixel(&cur[i * 3], &prev[i * 3])) {
+      int n = 1;                           // Unchanged span
+      while ((i + n < pixels) && (n < 0xFFFF) &&
+             samePixel(&cur[(i + n) * 3], &prev[(i + n) * 3]))
+        n++;
+      if (i + n == pixels) break;          // END covers a trailing skip
+      putOp(out, DSA_OP_SKIP, n);
+      i += n;
+      continue;
+    }
+    int run = runLength(cur, i, pixels);
+    if (run >= 3) {                        // FILL beats COPY from 3 up
+      putOp(out, DSA_OP_FILL, run);
+      out.insert(out.end(), &cur[i * 3], &cur[i * 3 + 3]);
+      i += run;
+      continue;
+    }
+    // Literal span: stops at unchanged pixels or the start of a fill
+    int n = 0;
+    while ((i + n < pixels) && (n < 0xFFFF)) {
+      if (prev && samePixel(&cur[(i + n) * 3], &prev[(i + n) * 3])) break;
+      if (runLength(cur, i + n, pixels) >= 3) break;
+      n++;
+    }
+    putOp(out, DSA_OP_COPY, n);
+    out.insert(out.end(), &cur[i * 3], &cur[(i + n) * 3]);
+    i += n;
+  }
+  out.push_back(DSA_OP_END);
+}
+
+static void usage(void) {
+  fprintf(stderr,
+    "usage: dsa-encode -n pixels [-d ms] [-k keyint] input.rgb output.dsa\n");
+  exit(1);
+}
+
+int main(int argc, char *argv[]) {
+  long pixels = 0, duration = 20, keyint = 0;
+  const char *inPath = NULL, *outPath = NULL;
+
+  for (int a = 1; a < argc; a++) {
+    if (!strcmp(argv[a], "-n") && (a + 1 < argc)) {
+      pixels = strtol(argv[++a], NULL, 0);
+    } else if (!strcmp(argv[a], "-d") && (a + 1 < argc)) {
+      duration = strtol(argv[++a], NULL, 0);
+    } else if (!strcmp(argv[a], "-k") && (a + 1 < argc)) {
+      keyint = strtol(argv[++a], NULL, 0);
+    } else if (!inPath) {
+      inPath = argv[a];
+    } else if (!outPath) {
+      outPath = argv[a];
+    } else {
+      usage();
+    }
+  }
+  if (!inPath || !outPath || (pixels < 1) || (pixels > 0xFFFF) ||
+      (duration < 0) || (duration > 0xFFFF) ||
+      (keyint < 0) || (keyint > 0xFFFF)) usage();
+
+  FILE *in = fopen(inPath, "rb");
+  if (!in) {
+    perror(inPath);
+    return 1;
+  }
+  size_t frameBytes = pixels * 3;
+  Bytes cur(frameBytes), prev(frameBytes), body;
+  long frames = 0, keyframes = 0;
+
+  while (fread(&cur[0], 1, frameBytes, in) == frameBytes) {
+    if (frames == 0xFFFF) {
+      fprintf(stderr, "%s: too many frames, truncating at 65535\n", inPath);
+      break;
+    }
+    bool key = (frames == 0) || (keyint && !(frames % keyint));
+    encodeFrame(body, &cur[0], key ? NULL : &prev[0], pixels, duration);
+    keyframes += key;
+    frames++;
+    cur.swap(prev);
+  }
+  fclose(in);
+  if (!frames) {
+    fprintf(stderr, "%s: no complete frames of %ld pixels\n", inPath, pixels);
+    return 1;
+  }
+
+  Bytes out;
+  out.push_back(DSA_MAGIC0);
+  out.push_back(DSA_MAGIC1);
+  out.push_back(DSA_MAGIC2);
+  out.push_back(DSA_MAGIC3);
+  put16(out, pixels);
+  put16(out, frames);
+  put16(out, keyint);
+  put16(out, 0);
+  out.insert(out.end(), body.begin(), body.end());
+
+  FILE *f = fopen(outPath, "wb");
+  if (!f || (fwrite(&out[0], 1, out.size(), f) != out.size())) {
+    perror(outPath);
+    return 1;
+  }
+  fclose(f);
+
+  printf("%ld frames (%ld key), %lu bytes raw -> %lu bytes (%.1f%%)\n",
+    frames, keyframes, (unsigned long)(frames * frameBytes),
+    (unsigned long)out.size(), 100.0 * out.size() / (frames * frameBytes));
+  return 0;
+}